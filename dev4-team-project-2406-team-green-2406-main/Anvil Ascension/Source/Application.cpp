@@ -1,7 +1,9 @@
 #include "Application.h"
-#include "Systems/load_data_oriented.h"
 #include "Systems/load_object_oriented.h"
 #include "Systems/OpenGLExtensions.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
 
 // Open some Gateware namespaces for convenience 
 // NEVER do this in a header file!
@@ -10,6 +12,24 @@ using namespace CORE;
 using namespace SYSTEM;
 using namespace GRAPHICS;
 
+bool Application::ParseCommandLine(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            headlessFrames = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            std::cerr << "Usage: [--headless] [--frames N] [--seed S]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 bool Application::Init()
 {
     eventPusher.Create();
@@ -18,22 +38,48 @@ bool Application::Init()
     gameConfig = std::make_shared<GameConfig>();
     // Create the ECS system
     game = std::make_shared<flecs::world>();
-    // Init all other systems
-    if (InitWindow() == false) {
-        std::cerr << "Failed to initialize window." << std::endl;
-        return false;
-    }
-    if (InitInput() == false) {
-        std::cerr << "Failed to initialize input." << std::endl;
-        return false;
+    // The ECS is always stepped at a fixed rate, rendering interpolates between steps
+    tickStep = 1.0 / gameConfig->at("Simulation").at("tickrate").as<double>();
+    maxTicksPerFrame = gameConfig->at("Simulation").at("maxticks").as<unsigned>();
+    threadedSimulation = gameConfig->at("Simulation").at("threaded").as<bool>() && headless == false;
+    // Multi-threaded systems are split across these workers, each gets its own deferred stage
+    unsigned workers = gameConfig->at("Threads").at("workers").as<unsigned>();
+    if (workers == 0)
+        workers = std::thread::hardware_concurrency();
+    if (workers > 1)
+        game->set_threads(static_cast<int32_t>(workers));
+    std::cout << "ECS running on " << ((workers > 1) ? workers : 1) << " thread(s)." << std::endl;
+    // Read the level layout once, the entities and both level loaders all build from this copy
+    {
+        ESG::Profiler::Scope timer(profiler, "Level Parse");
+        GW::SYSTEM::GLog log;
+        log.Create("../LevelLoaderLog.txt");
+        log.EnableConsoleLogging(true); // Mirror output to the console
+        std::string gameLevelPath = gameConfig->at("Level1").at("gamelevel").as<std::string>();
+        gameLevel = ESG::GameLevel::Parse(gameLevelPath.c_str(), log);
     }
-    if (InitAudio() == false) {
-        std::cerr << "Failed to initialize audio." << std::endl;
+    if (gameLevel == nullptr) {
+        std::cerr << "Failed to read game level." << std::endl;
         return false;
     }
-    if (InitGraphics() == false) {
-        std::cerr << "Failed to initialize graphics." << std::endl;
-        return false;
+    // Init all other systems, headless runs leave the window, input and audio handles empty
+    if (headless == false) {
+        if (InitWindow() == false) {
+            std::cerr << "Failed to initialize window." << std::endl;
+            return false;
+        }
+        if (InitInput() == false) {
+            std::cerr << "Failed to initialize input." << std::endl;
+            return false;
+        }
+        if (InitAudio() == false) {
+            std::cerr << "Failed to initialize audio." << std::endl;
+            return false;
+        }
+        if (InitGraphics() == false) {
+            std::cerr << "Failed to initialize graphics." << std::endl;
+            return false;
+        }
     }
     if (InitEntities() == false) {
         std::cerr << "Failed to initialize entities." << std::endl;
@@ -43,12 +89,23 @@ bool Application::Init()
         std::cerr << "Failed to initialize systems." << std::endl;
         return false;
     }
+    // Start timing once every system exists so all of them get sampled
+    if (profiler.Init(game, gameConfig) == false) {
+        std::cerr << "Failed to initialize profiler." << std::endl;
+        return false;
+    }
+    // Everything with a name and a position might match a model in the level
+    drawableQuery = game->query_builder<const ESG::Position>()
+        .term<flecs::Identifier>(flecs::Name)
+        .build();
 
     std::cout << "Initialization complete." << std::endl;
     return true;
 }
 
 bool Application::Run() {
+    if (headless)
+        return RunHeadless();
     std::cout << "Starting Run loop..." << std::endl;
 
     // Initialize and set up the window
@@ -59,41 +116,71 @@ bool Application::Run() {
     // Create the OpenGL surface and set up event handling
     if (+ogl.Create(window, GW::GRAPHICS::DEPTH_BUFFER_SUPPORT)) {
         QueryOGLExtensionFunctions(ogl); // Link needed OpenGL API functions
+        bool swapLocked = false; // vsync is holding the loop to the display
+        if (+ogl.EnableSwapControl(vsync))
+            swapLocked = vsync;
+        else if (vsync)
+            std::cerr << "Failed to set vsync, relying on the frame pacer." << std::endl;
         Level_Objects objectOrientedLoader(window, ogl);
-        objectOrientedLoader.LoadLevel("../GameLevel.txt", "../Models", log);
-        objectOrientedLoader.UploadLevelToGPU();
+        {
+            ESG::Profiler::Scope timer(profiler, "Level Load");
+            objectOrientedLoader.LoadLevel(*gameLevel, "../Models", log);
+            objectOrientedLoader.UploadLevelToGPU();
+        }
 
         GLuint shaderProgram = objectOrientedLoader.GetShaderProgram();
         float clr[] = { 0 / 255.0f, 0 / 255.0f, 0 / 255.0f, 1 };
 
         std::cout << "Entering main loop..." << std::endl;
+        // Start pacing once loading is done so the first frame isn't counted late.
+        // Sleeping to a cap on top of vsync only makes the two fight, so the pacer is for when vsync is off.
+        framePacer.SetTargetFPS(swapLocked ? 0 : gameConfig->at("Window").at("fps").as<unsigned>());
+
+        // From here on only the simulation thread may touch the ECS, the main thread just draws snapshots
+        std::thread simulationThread;
+        if (threadedSimulation) {
+            simulating = true;
+            simulationThread = std::thread(&Application::SimulationThread, this);
+        }
 
         // Main loop
         while (+window.ProcessWindowEvents()) {
 
-            float xchangeleft, xchangeright;
-            float input = 0;
-            const ESG::Position* pos = game->entity("anvil_low").get<ESG::Position>();
-            auto e = game->lookup("anvil_low");
-            if (e.is_valid())
-            {
-
-            }
-
             glClearColor(clr[0], clr[1], clr[2], clr[3]);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            static auto start = std::chrono::steady_clock::now();
-            double elapsed = std::chrono::duration<double>(
-                std::chrono::steady_clock::now() - start).count();
-            start = std::chrono::steady_clock::now();
-
-            // Update and render the level
-            objectOrientedLoader.UpdateAndRender(elapsed);
+            if (threadedSimulation) {
+                if (simulating == false)
+                    break; // the ECS asked to quit
+            }
+            else {
+                static auto start = std::chrono::steady_clock::now();
+                double elapsed = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+                start = std::chrono::steady_clock::now();
+
+                // Simulate whole ticks on this thread before drawing
+                if (GameLoop(elapsed) == false)
+                    break;
+            }
+            // Draw the newest finished tick, blended with the one before it
+            {
+                ESG::Profiler::Scope timer(profiler, "Render Pass");
+                const ESG::RenderSnapshot& frame = renderSnapshots.Acquire();
+                objectOrientedLoader.UpdateAndRender(frame, frame.Alpha(std::chrono::steady_clock::now()));
+            }
 
             ogl.UniversalSwapBuffers();
+            // Sleep off the rest of the frame instead of spinning on the CPU
+            framePacer.Wait();
         }
         std::cout << "Exiting main loop." << std::endl;
+        simulating = false;
+        if (simulationThread.joinable())
+            simulationThread.join();
+        if (framePacer.IsEnabled())
+            std::cout << "Frame pacer missed " << framePacer.GetMissedDeadlines() << " of "
+                << framePacer.GetFrameCount() << " frame deadlines." << std::endl;
         return true;
     }
     std::cerr << "Failed to create OpenGL surface." << std::endl;
@@ -102,6 +189,10 @@ bool Application::Run() {
 
 bool Application::Shutdown()
 {
+    drawableQuery.destruct();
+    // Dump the timings before the systems they describe go away
+    if (profiler.Shutdown() == false)
+        std::cerr << "Failed to save profile." << std::endl;
     // Disconnect systems from global ECS
     if (playerSystem.Shutdown() == false) {
         std::cerr << "Failed to shut down player system." << std::endl;
@@ -137,9 +228,6 @@ bool Application::InitWindow() {
     log.EnableConsoleLogging(true); // Mirror output to the console
     log.Log("Start Program.");
 
-    Level_Data dataOrientedLoader;
-    dataOrientedLoader.LoadLevel("../GameLevel.txt", "../Models", log);
-
     std::cout << "Window settings loaded from gameConfig." << std::endl;
 
     // Grab settings
@@ -148,6 +236,7 @@ bool Application::InitWindow() {
     int xstart = gameConfig->at("Window").at("xstart").as<int>();
     int ystart = gameConfig->at("Window").at("ystart").as<int>();
     std::string title = gameConfig->at("Window").at("title").as<std::string>();
+    vsync = gameConfig->at("Window").at("vsync").as<bool>();
 
     // Open window
     if (+window.Create(xstart, ystart, width, height, GWindowStyle::WINDOWEDBORDERED) &&
@@ -195,7 +284,7 @@ bool Application::InitEntities()
         return false;
     }
     // Load the player entities
-    if (players.Load(game, gameConfig) == false) {
+    if (players.Load(game, gameConfig, *gameLevel) == false) {
         std::cerr << "Failed to load player entities." << std::endl;
         return false;
     }
@@ -216,7 +305,7 @@ bool Application::InitSystems()
         std::cerr << "Failed to initialize player system." << std::endl;
         return false;
     }
-    if (levelSystem.Init(game, gameConfig, audioEngine) == false) {
+    if (levelSystem.Init(game, gameConfig, audioEngine, seed, headless) == false) {
         std::cerr << "Failed to initialize level system." << std::endl;
         return false;
     }
@@ -269,16 +358,99 @@ bool Application::InitGraphics() {
     return false;
 }
 
-bool Application::GameLoop()
+bool Application::GameLoop(double frameTime)
+{
+    // Bank the frame's wall clock time and pay it out in fixed size ticks
+    tickAccumulator += frameTime;
+    unsigned ticks = 0;
+    while (tickAccumulator >= tickStep) {
+        if (ticks == maxTicksPerFrame) {
+            // Too far behind to catch up, drop the backlog instead of stalling
+            tickAccumulator = 0;
+            break;
+        }
+        // Let the ECS system run
+        {
+            ESG::Profiler::Scope timer(profiler, "Tick");
+            if (game->progress(static_cast<float>(tickStep)) == false)
+                return false;
+        }
+        profiler.SampleSystems();
+        tickAccumulator -= tickStep;
+        ++ticks;
+        ++ticksSimulated;
+    }
+    // Only hand the renderer a new snapshot when something actually moved
+    if (ticks > 0)
+        PublishRenderSnapshot();
+    return true;
+}
+
+bool Application::RunHeadless()
+{
+    std::cout << "Simulating " << headlessFrames << " ticks headless (seed " << seed << ")..." << std::endl;
+
+    // Step as fast as possible, every tick still covers the same game time as a windowed run
+    unsigned frame = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (; frame < headlessFrames; ++frame) {
+        {
+            ESG::Profiler::Scope timer(profiler, "Tick");
+            if (game->progress(static_cast<float>(tickStep)) == false)
+                break;
+        }
+        profiler.SampleSystems();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Simulated " << frame << " ticks in " << seconds * 1000.0 << " ms ("
+        << ((frame > 0) ? seconds * 1000.0 / frame : 0.0) << " ms per tick)." << std::endl;
+    profiler.Print(std::cout);
+    return true;
+}
+
+void Application::SimulationThread()
 {
-    // Compute delta time and pass to the ECS system
-    static auto start = std::chrono::steady_clock::now();
-    double elapsed = std::chrono::duration<double>(
-        std::chrono::steady_clock::now() - start).count();
-    start = std::chrono::steady_clock::now();
-
-    // Let the ECS system run
-    return game->progress(static_cast<float>(elapsed));
+    auto start = std::chrono::steady_clock::now();
+    while (simulating) {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        start = now;
+
+        if (GameLoop(elapsed) == false) {
+            simulating = false; // let the main loop know the game is over
+            break;
+        }
+        // Nothing to do until the next tick is due
+        std::this_thread::sleep_for(std::chrono::duration<double>(tickStep - tickAccumulator));
+    }
+}
+
+void Application::PublishRenderSnapshot()
+{
+    ESG::RenderSnapshot& snapshot = renderSnapshots.BeginWrite();
+    // Overwrite the instances in place so their strings and the vector keep their memory between ticks
+    size_t count = 0;
+    drawableQuery.each([&snapshot, &count](flecs::entity e, const ESG::Position& p) {
+        if (count == snapshot.instances.size())
+            snapshot.instances.emplace_back();
+        ESG::RenderInstance& instance = snapshot.instances[count++];
+        instance.name = e.name().c_str();
+        instance.currentPosition = p.value;
+        const ESG::PreviousPosition* previous = e.get<ESG::PreviousPosition>();
+        instance.previousPosition = (previous != nullptr) ? previous->value : p.value;
+        const ESG::Orientation* orientation = e.get<ESG::Orientation>();
+        instance.orientation = (orientation != nullptr) ? orientation->value : GW::MATH::GIdentityMatrixF;
+        });
+    snapshot.instances.resize(count);
+    std::sort(snapshot.instances.begin(), snapshot.instances.end(),
+        [](const ESG::RenderInstance& a, const ESG::RenderInstance& b) { return a.name < b.name; });
+    // Leftover accumulator time is how long ago the last tick should have ended
+    snapshot.tickStep = tickStep;
+    snapshot.tick = ticksSimulated;
+    snapshot.simulatedUntil = std::chrono::steady_clock::now() -
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(tickAccumulator));
+    renderSnapshots.Publish();
 }
 
 
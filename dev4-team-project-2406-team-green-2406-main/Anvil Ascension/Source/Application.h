@@ -15,6 +15,16 @@
 #include "Systems/PhysicsLogic.h"
 #include "Systems/BulletLogic.h"
 #include "Systems/EnemyLogic.h"
+// Parsed GameLevel.txt shared by the level loaders and entities
+#include "Systems/GameLevel.h"
+// Keeps the main loop at a steady frame rate
+#include "../../Shared/FramePacer.h"
+// Hands finished simulation ticks over to the renderer
+#include "Systems/RenderSnapshot.h"
+// Times systems, loading and rendering
+#include "Utils/Profiler.h"
+#include <atomic>
+#include <thread>
 
 // Allocates and runs all sub-systems essential to operating the game
 class Application 
@@ -28,6 +38,7 @@ class Application
 	// third-party gameplay & utility libraries
 	std::shared_ptr<flecs::world> game; // ECS database for gameplay
 	std::shared_ptr<GameConfig> gameConfig; // .ini file game settings
+	std::shared_ptr<const ESG::GameLevel> gameLevel; // level layout, parsed once for every loader
 	// ECS Entities and Prefabs that need to be loaded
 	ESG::BulletData weapons;
 	ESG::PlayerData players;
@@ -40,8 +51,28 @@ class Application
 	ESG::EnemyLogic enemySystem;
 	// EventGenerator for Game Events
 	GW::CORE::GEventGenerator eventPusher;
+	// fixed timestep simulation state (see [Simulation] in defaults.ini)
+	double tickStep = 1.0 / 60.0; // seconds of game time each ECS progress covers
+	double tickAccumulator = 0; // wall clock time not yet simulated
+	unsigned maxTicksPerFrame = 5; // cap so one slow frame can't snowball
+	unsigned long long ticksSimulated = 0; // total ECS progress calls so far
+	// pipelined rendering, the simulation can run ahead on its own thread (see [Simulation] threaded)
+	ESG::RenderSnapshotBuffer renderSnapshots; // each finished tick copied out for the renderer
+	flecs::query<const ESG::Position> drawableQuery; // named entities the renderer may draw
+	bool threadedSimulation = true; // simulate on a worker thread while the main thread draws
+	std::atomic_bool simulating = false; // cleared to stop the simulation thread (or by it when the ECS quits)
+	// headless mode, simulates a fixed number of ticks with no window, GL, input or audio
+	bool headless = false;
+	unsigned headlessFrames = 600; // ticks to simulate before exiting
+	unsigned seed = 0; // enemy spawn seed, 0 = random
+	// rolling timings of every system, loading and rendering (see [Profiler] in defaults.ini)
+	ESG::Profiler profiler;
+	// frame pacing (see [Window] in defaults.ini)
+	FramePacer framePacer; // sleeps off whatever is left of each frame
+	bool vsync = true; // let the driver hold buffer swaps to the display refresh
 
 public:
+	bool ParseCommandLine(int argc, char* argv[]);
 	bool Init();
 	bool Run();
 	bool Shutdown();
@@ -52,7 +83,10 @@ private:
 	bool InitGraphics();
 	bool InitEntities();
 	bool InitSystems();
-	bool GameLoop();
+	bool GameLoop(double frameTime);
+	bool RunHeadless();
+	void SimulationThread();
+	void PublishRenderSnapshot();
 };
 
 #endif 
\ No newline at end of file
@@ -11,6 +11,8 @@ namespace ESG
 	struct Velocity { GW::MATH::GVECTORF value; }; // 3D vector
 	struct Orientation { GW::MATH::GMATRIXF value; }; // 3D matrix
 	struct Acceleration { GW::MATH::GVECTORF value; }; // 3D vector
+	// Position at the start of the current simulation tick (render interpolation)
+	struct PreviousPosition { GW::MATH::GVECTORF value; }; // 3D vector
 
 	// Individual TAGs
 	struct Collidable {}; 
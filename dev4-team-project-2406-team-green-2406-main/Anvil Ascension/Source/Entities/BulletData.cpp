@@ -30,7 +30,8 @@ bool ESG::BulletData::Load(std::shared_ptr<flecs::world> _game,
 
     // Load sound effect used by this ball entity
     GW::AUDIO::GSound shoot;
-    shoot.Create(fireFX.c_str(), _audioEngine, 0.15f); // we need a global music & sfx volumes
+    if (_audioEngine) // empty when running headless
+        shoot.Create(fireFX.c_str(), _audioEngine, 0.15f); // we need a global music & sfx volumes
 
     // add ball entity to ECS
     auto ballEntity = _game->entity("Ball")
@@ -4,6 +4,8 @@
 
 // Contains our global game settings
 #include "../GameConfig.h"
+// Parsed level layout the player start is read from
+#include "../Systems/GameLevel.h"
 
 
 // example space game (avoid name collisions)
@@ -12,10 +14,12 @@ namespace ESG
 	class PlayerData
 	{
 	public:
-		bool ESG::PlayerData::ParseGameLevelFile(const std::string& filePath, std::string& modelName, float& xstart, float& ystart, float& zstart, float& scale);
+		// find the player's model in the level and pull its start location and scale
+		bool FindPlayerStart(const GameLevel& gameLevel, std::string& modelName, float& xstart, float& ystart, float& zstart, float& scale);
 		// Load required entities and/or prefabs into the ECS 
 		bool Load(	std::shared_ptr<flecs::world> _game,
-					std::weak_ptr<const GameConfig> _gameConfig);
+					std::weak_ptr<const GameConfig> _gameConfig,
+					const GameLevel& _gameLevel);
 		// Unload the entities/prefabs from the ECS
 		bool Unload(std::shared_ptr<flecs::world> _game);
 	};
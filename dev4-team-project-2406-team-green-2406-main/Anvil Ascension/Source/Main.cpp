@@ -1,10 +1,11 @@
 // handles everything
 #include "Application.h"
 // program entry point
-int main()
+// pass --headless --frames N --seed S to simulate without a window, GL or audio
+int main(int argc, char* argv[])
 {
 	Application exampleSpaceGame;
-	if (exampleSpaceGame.Init()) {
+	if (exampleSpaceGame.ParseCommandLine(argc, argv) && exampleSpaceGame.Init()) {
 		if (exampleSpaceGame.Run()) {
 			return exampleSpaceGame.Shutdown() ? 0 : 1;
 		}
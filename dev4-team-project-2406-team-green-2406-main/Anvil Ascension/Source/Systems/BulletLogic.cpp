@@ -16,6 +16,7 @@ bool ESG::BulletLogic::Init(std::shared_ptr<flecs::world> _game,
 	gameConfig = _gameConfig;
 
 	// destroy any balls that have the CollidedWith relationship
+	// single threaded, it reads and writes Health on the entities it hit and two bullets can hit the same one
 	game->system<Bullet, Damage>("Bullet System")
 		.each([](flecs::entity e, Bullet, Damage& d) {
 		// damage anything we come into contact with
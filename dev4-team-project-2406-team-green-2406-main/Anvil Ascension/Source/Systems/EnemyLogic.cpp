@@ -18,7 +18,9 @@ bool ESG::EnemyLogic::Init(std::shared_ptr<flecs::world> _game,
 	eventPusher = _eventPusher;
 
 	// destroy any bullets that have the CollidedWith relationship
+	// runs across worker threads, destructs are deferred and GEventGenerator pushes are thread safe
 	game->system<Enemy, Health>("Enemy System")
+		.multi_threaded()
 		.each([this](flecs::entity e, Enemy, Health& h) {
 			// if you have no health left be destroyed
 			if (e.get<Health>()->value <= 0) {
@@ -0,0 +1,91 @@
+#include "GameLevel.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace ESG; // Example Space Game
+
+std::shared_ptr<const GameLevel> ESG::GameLevel::Parse(const char* gameLevelPath, GW::SYSTEM::GLog log)
+{
+	log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
+	GW::SYSTEM::GFile file;
+	file.Create();
+	if (-file.OpenTextRead(gameLevelPath)) {
+		log.LogCategorized("ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
+		return nullptr;
+	}
+	auto level = std::make_shared<GameLevel>();
+	level->path = gameLevelPath;
+
+	char linebuffer[1024];
+	while (+file.ReadLine(linebuffer, 1024, '\n')) {
+		if (linebuffer[0] == '\0')
+			break;
+		if (std::strcmp(linebuffer, "MESH") == 0) {
+			Mesh mesh;
+			file.ReadLine(linebuffer, 1024, '\n');
+			mesh.blenderName = linebuffer;
+			log.LogCategorized("INFO", (std::string("Model Detected: ") + mesh.blenderName).c_str());
+			// blender adds .001 style suffixes to copies, everything after the first dot is dropped so they share one .h2b
+			mesh.modelFile = mesh.blenderName.substr(0, mesh.blenderName.find_first_of(".")) + ".h2b";
+			for (int i = 0; i < 4; ++i) {
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
+					&mesh.transform.data[0 + i * 4], &mesh.transform.data[1 + i * 4],
+					&mesh.transform.data[2 + i * 4], &mesh.transform.data[3 + i * 4]);
+			}
+			level->meshes.push_back(std::move(mesh));
+		}
+		// the optional lines below belong to the last MESH read
+		else if (std::strcmp(linebuffer, "TEXTURE") == 0 && level->meshes.empty() == false) {
+			file.ReadLine(linebuffer, 1024, '\n');
+			level->meshes.back().texturePath = linebuffer;
+		}
+		else if (std::strncmp(linebuffer, "<Vector", 7) == 0 && level->meshes.empty() == false) {
+			Mesh& mesh = level->meshes.back();
+			// eight corners in a row, one per line
+			for (int i = 0; i < 8; ++i) {
+				if (i > 0)
+					file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer + 9, "%f, %f, %f",
+					&mesh.bounds[i].x, &mesh.bounds[i].y, &mesh.bounds[i].z);
+			}
+			mesh.hasBounds = true;
+		}
+		else if (std::strcmp(linebuffer, "LIGHT") == 0) {
+			file.ReadLine(linebuffer, 1024, '\n'); // Read the type
+			Light light;
+			light.type = linebuffer;
+			if (light.type == "SUN") {
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer, "Color: %f %f %f", &light.color.x, &light.color.y, &light.color.z);
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer, "Direction: %f %f %f", &light.direction.x, &light.direction.y, &light.direction.z);
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer, "Energy: %f", &light.energy);
+			}
+			else if (light.type == "POINT") {
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer, "Color: %f %f %f", &light.color.x, &light.color.y, &light.color.z);
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer, "Position: %f %f %f", &light.position.x, &light.position.y, &light.position.z);
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer, "Energy: %f", &light.energy);
+			}
+			else
+				continue; // camera/named light blocks, nothing we use
+			light.color.w = 1.0f;
+			level->lights.push_back(light);
+		}
+	}
+	log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
+	return level;
+}
+
+const GameLevel::Mesh* ESG::GameLevel::FindMesh(const std::string& blenderName) const
+{
+	for (const Mesh& mesh : meshes) {
+		if (mesh.blenderName == blenderName)
+			return &mesh;
+	}
+	return nullptr;
+}
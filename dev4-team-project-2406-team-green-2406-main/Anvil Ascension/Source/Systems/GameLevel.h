@@ -0,0 +1,50 @@
+// The game level is the parsed contents of a GameLevel*.txt file, read once and shared by every loader
+#ifndef GAMELEVEL_H
+#define GAMELEVEL_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// example space game (avoid name collisions)
+namespace ESG
+{
+	class GameLevel
+	{
+	public:
+		// one MESH entry exported from blender
+		struct Mesh {
+			std::string blenderName; // unique object name (ex: Wall_Cube.020)
+			std::string modelFile; // .h2b file the object uses (ex: Wall_Cube.h2b)
+			GW::MATH::GMATRIXF transform;
+			std::string texturePath; // empty if the entry had no TEXTURE
+			// object aligned bounding box corners if exported: LBN, LTN, LTF, LBF, RBN, RTN, RTF, RBF
+			GW::MATH2D::GVECTOR3F bounds[8] = {};
+			bool hasBounds = false;
+		};
+		// one LIGHT entry with a SUN or POINT type line
+		struct Light {
+			std::string type; // "SUN" or "POINT"
+			GW::MATH::GVECTORF color = {};
+			GW::MATH::GVECTORF direction = {}; // SUN only
+			GW::MATH::GVECTORF position = {}; // POINT only
+			float energy = 0;
+		};
+
+		// Reads the whole file, returns nullptr if it can't be opened.
+		// The result is const so every system can hold on to the same copy.
+		static std::shared_ptr<const GameLevel> Parse(const char* gameLevelPath, GW::SYSTEM::GLog log);
+
+		const std::string& GetPath() const { return path; }
+		const std::vector<Mesh>& GetMeshes() const { return meshes; }
+		const std::vector<Light>& GetLights() const { return lights; }
+		// first mesh with this blender name, nullptr if there isn't one
+		const Mesh* FindMesh(const std::string& blenderName) const;
+	private:
+		std::string path;
+		std::vector<Mesh> meshes; // in file order
+		std::vector<Light> lights; // in file order
+	};
+};
+
+#endif
@@ -10,7 +10,9 @@ using namespace ESG; // Example Space Game
 // Connects logic to traverse any players and allow a controller to manipulate them
 bool ESG::LevelLogic::Init(	std::shared_ptr<flecs::world> _game,
 							std::weak_ptr<const GameConfig> _gameConfig,
-							GW::AUDIO::GAudio _audioEngine)
+							GW::AUDIO::GAudio _audioEngine,
+							unsigned _seed,
+							bool _gameTimeSpawns)
 {
 	// save a handle to the ECS & game settings
 	game = _game;
@@ -21,41 +23,41 @@ bool ESG::LevelLogic::Init(	std::shared_ptr<flecs::world> _game,
 	gameLock.Create();
 	// Pull enemy Y start location from config file
 	std::shared_ptr<const GameConfig> readCfg = _gameConfig.lock();
-	float enemy1startY = (*readCfg).at("Enemy1").at("ystart").as<float>();
-	float enemy1accmax = (*readCfg).at("Enemy1").at("accmax").as<float>();
-	float enemy1accmin = (*readCfg).at("Enemy1").at("accmin").as<float>();
+	enemyStartY = (*readCfg).at("Enemy1").at("ystart").as<float>();
+	enemyAccMax = (*readCfg).at("Enemy1").at("accmax").as<float>();
+	enemyAccMin = (*readCfg).at("Enemy1").at("accmin").as<float>();
 	// level one info
 	float spawnDelay = (*readCfg).at("Level1").at("spawndelay").as<float>();
+	// a fixed seed gives the same enemy waves every run
+	spawnRandom.seed((_seed != 0) ? _seed : std::random_device()());
 	
-	// spins up a job in a thread pool to invoke a function at a regular interval
-	timedEvents.Create(spawnDelay * 1000, [this, enemy1startY, enemy1accmax, enemy1accmin]() {
-		// compute random spawn location
-		std::random_device rd;  // Will be used to obtain a seed for the random number engine
-		std::mt19937 gen(rd()); // Standard mersenne_twister_engine seeded with rd()
-		std::uniform_real_distribution<float> x_range(-0.9f, +0.9f);
-		std::uniform_real_distribution<float> a_range(enemy1accmin, enemy1accmax);
-		float Xstart = x_range(gen); // normal rand() doesn't work great multi-threaded
-		float accel = a_range(gen);
-		// grab enemy type 1 prefab
-		flecs::entity et1; 
-		if (RetreivePrefab("Enemy Type1", et1)) {
+	if (_gameTimeSpawns) {
+		// spawn on the ECS clock so the waves only depend on how many ticks were simulated
+		game->system("Spawn System").kind(flecs::OnLoad)
+			.interval(spawnDelay)
+			.iter([this](flecs::iter& it) {
+			if (it.world().time() >= 5.0f) { // wait 5 seconds to start enemy wave
+				flecs::world stage = it.world();
+				SpawnEnemy(stage);
+			}
+		});
+	}
+	else {
+		// spins up a job in a thread pool to invoke a function at a regular interval
+		timedEvents.Create(spawnDelay * 1000, [this]() {
 			// you must ensure the async_stage is thread safe as it has no built-in synchronization
 			gameLock.LockSyncWrite();
-			// this method of using prefabs is pretty conveinent
-			gameAsync.entity().is_a(et1)
-				.set<Velocity>({ 0,0 })
-				.set<Acceleration>({ 0, -accel })
-				.set<Position>({ Xstart, enemy1startY });
+			SpawnEnemy(gameAsync);
 			// be sure to unlock when done so the main thread can safely merge the changes
 			gameLock.UnlockSyncWrite();
-		}
-	}, 5000); // wait 5 seconds to start enemy wave
+		}, 5000); // wait 5 seconds to start enemy wave
+	}
 
 	// create a system the runs at the end of the frame only once to merge async changes
 	struct LevelSystem {}; // local definition so we control iteration counts
 	game->entity("Level System").add<LevelSystem>();
 	// only happens once per frame at the very start of the frame
-	game->system<LevelSystem>().kind(flecs::OnLoad) // first defined phase
+	game->system<LevelSystem>("Level Merge System").kind(flecs::OnLoad) // first defined phase
 		.each([this](flecs::entity e, LevelSystem& s) {
 		// merge any waiting changes from the last frame that happened on other threads
 		gameLock.LockSyncWrite();
@@ -63,9 +65,11 @@ bool ESG::LevelLogic::Init(	std::shared_ptr<flecs::world> _game,
 		gameLock.UnlockSyncWrite();
 	});
 
-	// Load and play level one's music
-	currentTrack.Create("../Music/Background.wav", audioEngine, 0.35f);
-	currentTrack.Play(true);
+	// Load and play level one's music, headless runs hand over an empty audio engine
+	if (audioEngine) {
+		currentTrack.Create("../Music/Background.wav", audioEngine, 0.35f);
+		currentTrack.Play(true);
+	}
 
 	return true;
 }
@@ -76,12 +80,32 @@ bool ESG::LevelLogic::Shutdown()
 	timedEvents = nullptr; // stop adding enemies
 	gameAsync.merge(); // get rid of any remaining commands
 	game->entity("Level System").destruct();
+	game->entity("Spawn System").destruct();
 	// invalidate the shared pointers
 	game.reset();
 	gameConfig.reset();
 	return true;
 }
 
+// Only ever called by one spawner at a time (under gameLock for the daemon)
+void ESG::LevelLogic::SpawnEnemy(flecs::world& stage)
+{
+	// compute random spawn location
+	std::uniform_real_distribution<float> x_range(-0.9f, +0.9f);
+	std::uniform_real_distribution<float> a_range(enemyAccMin, enemyAccMax);
+	float Xstart = x_range(spawnRandom);
+	float accel = a_range(spawnRandom);
+	// grab enemy type 1 prefab
+	flecs::entity et1;
+	if (RetreivePrefab("Enemy Type1", et1)) {
+		// this method of using prefabs is pretty conveinent
+		stage.entity().is_a(et1)
+			.set<Velocity>({ 0,0 })
+			.set<Acceleration>({ 0, -accel })
+			.set<Position>({ Xstart, enemyStartY });
+	}
+}
+
 // Toggle if a system's Logic is actively running
 bool ESG::LevelLogic::Activate(bool runSystem)
 {
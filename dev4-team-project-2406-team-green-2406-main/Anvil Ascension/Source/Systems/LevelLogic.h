@@ -7,6 +7,7 @@
 // Entities for players, enemies & bullets
 #include "../Entities/PlayerData.h"
 #include "../Entities/BulletData.h"
+#include <random>
 
 // example space game (avoid name collisions)
 namespace ESG
@@ -26,11 +27,19 @@ namespace ESG
 		GW::AUDIO::GMusic currentTrack;
 		// Used to spawn enemies at a regular intervals on another thread
 		GW::SYSTEM::GDaemon timedEvents;
+		// picks enemy spawn locations, seeded so headless runs can be repeated
+		std::mt19937 spawnRandom;
+		float enemyStartY = 0, enemyAccMin = 0, enemyAccMax = 0;
+		// creates one enemy from the prefab in the given world/stage
+		void SpawnEnemy(flecs::world& stage);
 	public:
 		// attach the required logic to the ECS 
+		// seed 0 picks a random seed, gameTimeSpawns spawns from an ECS timer instead of a wall clock thread
 		bool Init(	std::shared_ptr<flecs::world> _game,
 					std::weak_ptr<const GameConfig> _gameConfig,
-					GW::AUDIO::GAudio _audioEngine);
+					GW::AUDIO::GAudio _audioEngine,
+					unsigned _seed = 0,
+					bool _gameTimeSpawns = false);
 		// control if the system is actively running
 		bool Activate(bool runSystem);
 		// release any resources allocated by the system
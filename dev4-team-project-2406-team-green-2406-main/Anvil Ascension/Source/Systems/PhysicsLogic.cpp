@@ -96,7 +96,19 @@ bool ESG::PhysicsLogic::Init(std::shared_ptr<flecs::world> _game, std::weak_ptr<
     game = _game;
     gameConfig = _gameConfig;
 
+    // per entity systems below only touch their own entity so they can be split across worker threads,
+    // anything structural (adding PreviousPosition, destructing) is deferred until the workers sync
+
+    // remember where everything was before this tick moves it so rendering can interpolate
+    game->system<const Position>("Snapshot System")
+        .kind(flecs::PreUpdate)
+        .multi_threaded()
+        .each([](flecs::entity e, const Position& p) {
+        e.set<PreviousPosition>({ p.value });
+            });
+
     game->system<Velocity, const Acceleration>("Acceleration System")
+        .multi_threaded()
         .each([](flecs::entity e, Velocity& v, const Acceleration& a) {
         GW::MATH::GVECTORF accel;
     GW::MATH::GVector::ScaleF(a.value, e.delta_time(), accel);
@@ -104,6 +116,7 @@ bool ESG::PhysicsLogic::Init(std::shared_ptr<flecs::world> _game, std::weak_ptr<
             });
 
     game->system<Position, const Velocity>("Translation System")
+        .multi_threaded()
         .each([](flecs::entity e, Position& p, const Velocity& v) {
         GW::MATH::GVECTORF speed;
     GW::MATH::GVector::ScaleF(v.value, e.delta_time(), speed);
@@ -111,6 +124,7 @@ bool ESG::PhysicsLogic::Init(std::shared_ptr<flecs::world> _game, std::weak_ptr<
             });
 
     game->system<const Position>("Cleanup System")
+        .multi_threaded()
         .each([](flecs::entity e, const Position& p) {
         if (p.value.x > 1.5f || p.value.x < -1.5f ||
         p.value.y > 1.5f || p.value.y < -1.5f ||
@@ -121,9 +135,10 @@ bool ESG::PhysicsLogic::Init(std::shared_ptr<flecs::world> _game, std::weak_ptr<
 
     queryCache = game->query<Collidable, Position, Orientation>();
 
+    // single threaded, gathers every collidable into one shared cache
     struct CollisionSystem {};
     game->entity("Detect-Collisions").add<CollisionSystem>();
-    game->system<CollisionSystem>()
+    game->system<CollisionSystem>("Collision System")
         .each([this](CollisionSystem& s) {
         constexpr GW::MATH::GVECTORF poly[polysize] = {
             { -0.5f, -0.5f, 0 }, { 0, 0.5f, 0 }, { 0.5f, -0.5f, 0 }, { 0, -0.25f, 0 }
@@ -179,11 +194,13 @@ bool ESG::PhysicsLogic::Init(std::shared_ptr<flecs::world> _game, std::weak_ptr<
 bool ESG::PhysicsLogic::Activate(bool runSystem)
 {
     if (runSystem) {
+        game->entity("Snapshot System").enable();
         game->entity("Acceleration System").enable();
         game->entity("Translation System").enable();
         game->entity("Cleanup System").enable();
     }
     else {
+        game->entity("Snapshot System").disable();
         game->entity("Acceleration System").disable();
         game->entity("Translation System").disable();
         game->entity("Cleanup System").disable();
@@ -194,6 +211,7 @@ bool ESG::PhysicsLogic::Activate(bool runSystem)
 bool ESG::PhysicsLogic::Shutdown()
 {
     queryCache.destruct();
+    game->entity("Snapshot System").destruct();
     game->entity("Acceleration System").destruct();
     game->entity("Translation System").destruct();
     game->entity("Cleanup System").destruct();
@@ -0,0 +1,73 @@
+// The render snapshot is everything the renderer needs from one simulation tick, copied out of the ECS
+// so the simulation can move on to the next tick while the previous one is being drawn.
+#ifndef RENDERSNAPSHOT_H
+#define RENDERSNAPSHOT_H
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// example space game (avoid name collisions)
+namespace ESG
+{
+	// One drawable entity as it was at the end of a tick
+	struct RenderInstance {
+		std::string name; // matched against model names in the level
+		GW::MATH::GVECTORF previousPosition; // where the tick started
+		GW::MATH::GVECTORF currentPosition; // where the tick ended
+		GW::MATH::GMATRIXF orientation;
+	};
+
+	struct RenderSnapshot {
+		std::vector<RenderInstance> instances; // sorted by name
+		std::chrono::steady_clock::time_point simulatedUntil; // wall clock time currentPosition belongs to
+		double tickStep = 1.0 / 60.0;
+		unsigned long long tick = 0; // 0 means nothing has been simulated yet
+
+		const RenderInstance* Find(const std::string& name) const {
+			auto found = std::lower_bound(instances.begin(), instances.end(), name,
+				[](const RenderInstance& i, const std::string& n) { return i.name < n; });
+			return (found != instances.end() && found->name == name) ? &(*found) : nullptr;
+		}
+
+		// how far past the last tick the renderer is, 0 = previousPosition and 1 = currentPosition
+		float Alpha(std::chrono::steady_clock::time_point now) const {
+			double alpha = std::chrono::duration<double>(now - simulatedUntil).count() / tickStep;
+			if (alpha < 0.0) alpha = 0.0;
+			if (alpha > 1.0) alpha = 1.0;
+			return static_cast<float>(alpha);
+		}
+	};
+
+	// The simulation fills one snapshot while the renderer reads the other.
+	// A third slot holds the newest finished snapshot so neither side ever waits on the other for long.
+	class RenderSnapshotBuffer {
+		RenderSnapshot slots[3];
+		unsigned writing = 0, ready = 1, reading = 2;
+		bool fresh = false; // ready holds a snapshot the renderer hasn't picked up
+		std::mutex handoff;
+	public:
+		// Simulation side, fill this in then Publish() it
+		RenderSnapshot& BeginWrite() {
+			return slots[writing];
+		}
+		void Publish() {
+			std::lock_guard<std::mutex> lock(handoff);
+			std::swap(writing, ready);
+			fresh = true;
+		}
+		// Render side, returns the newest published snapshot (or the last one again if nothing new)
+		const RenderSnapshot& Acquire() {
+			std::lock_guard<std::mutex> lock(handoff);
+			if (fresh) {
+				std::swap(reading, ready);
+				fresh = false;
+			}
+			return slots[reading];
+		}
+	};
+};
+
+#endif
@@ -4,6 +4,8 @@
 
 // This reads .h2b files which are optimized binary .obj+.mtl files
 #include "h2bParser.h"
+// The level layout comes in already parsed
+#include "GameLevel.h"
 
 // * NOTE: *
 // Unlike the OOP version, this class was not designed to be a dynamic/evolving data structure.
@@ -72,13 +74,13 @@ public:
 	// *NEW* each item from the blender scene graph
 	std::vector<BLENDER_OBJECT> blenderObjects;
 	
-	// Imports the default level txt format and collects all .h2b data
-	bool LoadLevel(const char* gameLevelPath, const char* h2bFolderPath, GW::SYSTEM::GLog log) {
+	// Collects all .h2b data used by an already parsed level
+	bool LoadLevel(const ESG::GameLevel& gameLevel, const char* h2bFolderPath, GW::SYSTEM::GLog log) {
 		log.LogCategorized("EVENT", "LOADING GAME LEVEL [DATA ORIENTED]");
 
 		UnloadLevel(); // clear previous level data if there is any
 		std::set<MODEL_ENTRY> uniqueModels; // unique models and their locations
-		if (ReadGameLevel(gameLevelPath, uniqueModels, log) == false) {
+		if (ReadGameLevel(gameLevel, uniqueModels, log) == false) {
 			log.LogCategorized("ERROR", "Fatal error reading game level, aborting level load.");
 			return false;
 		}
@@ -138,61 +140,24 @@ private:
 			return out;
 		}
 	};
-	// internal helper for reading the game level
-	bool ReadGameLevel(const char* gameLevelPath, std::set<MODEL_ENTRY>& outModels, GW::SYSTEM::GLog log) {
-		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
-		GW::SYSTEM::GFile file;
-		file.Create();
-		if (-file.OpenTextRead(gameLevelPath)) {
-			log.LogCategorized("ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
-			return false;
-		}
-		char linebuffer[1024];
-		while (+file.ReadLine(linebuffer, 1024, '\n')) {
-			if (linebuffer[0] == '\0')
-				break;
-			if (std::strcmp(linebuffer, "MESH") == 0) {
-				file.ReadLine(linebuffer, 1024, '\n');
-				std::string blenderName = linebuffer;
-				log.LogCategorized("INFO", (std::string("Model Detected: ") + blenderName).c_str());
-
-				MODEL_ENTRY add = { linebuffer };
-				add.modelFile = add.modelFile.substr(0, add.modelFile.find_last_of("."));
-				add.modelFile += ".h2b";
-
-				// now read the transform data as we will need that regardless
-				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
-						&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-						&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-				log.LogCategorized("INFO", loc.c_str());
-
-				// read the texture file path
-				std::string textureFilePath;
-				file.ReadLine(linebuffer, 1024, '\n');
-				textureFilePath = linebuffer;
-
-				// does this model already exist?
-				auto found = outModels.find(add);
-				if (found == outModels.end()) {
-					add.blenderNames.push_back(blenderName);
-					add.instances.push_back(transform);
-					add.textureFilePath = textureFilePath; // store the texture file path
-					outModels.insert(add);
-				}
-				else {
-					found->blenderNames.push_back(blenderName);
-					found->instances.push_back(transform);
-				}
+	// internal helper for grouping the level's objects by the model they use
+	bool ReadGameLevel(const ESG::GameLevel& gameLevel, std::set<MODEL_ENTRY>& outModels, GW::SYSTEM::GLog log) {
+		for (const ESG::GameLevel::Mesh& mesh : gameLevel.GetMeshes()) {
+			MODEL_ENTRY add = { mesh.modelFile };
+			// does this model already exist?
+			auto found = outModels.find(add);
+			if (found == outModels.end()) {
+				add.blenderNames.push_back(mesh.blenderName);
+				add.instances.push_back(mesh.transform);
+				add.textureFilePath = mesh.texturePath;
+				std::copy(std::begin(mesh.bounds), std::end(mesh.bounds), std::begin(add.boundry));
+				outModels.insert(add);
+			}
+			else {
+				found->blenderNames.push_back(mesh.blenderName);
+				found->instances.push_back(mesh.transform);
 			}
 		}
-		log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
 		return true;
 	}
 	// internal helper for collecting all .h2b data into unified arrays
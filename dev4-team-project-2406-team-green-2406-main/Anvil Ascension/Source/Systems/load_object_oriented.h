@@ -9,6 +9,8 @@
 #include "OpenGLExtensions.h"
 #include "../Components/Physics.h"
 #include "../Components/Visuals.h"
+#include "RenderSnapshot.h"
+#include "GameLevel.h"
 #include "../../flecs-3.1.4/flecs.h"
 #include <vector>
 #include <list>
@@ -318,7 +320,8 @@ public:
 		return shaderExecutable;
 	}
 
-	Level_Objects(GW::SYSTEM::GWindow _win, GW::GRAPHICS::GOpenGLSurface _ogl) : win(_win), ogl(_ogl), ecs(std::make_shared<flecs::world>()) {
+	Level_Objects(GW::SYSTEM::GWindow _win, GW::GRAPHICS::GOpenGLSurface _ogl)
+		: win(_win), ogl(_ogl), ecs(std::make_shared<flecs::world>()) {
 		InitializeMatricesAndLighting();
 		InitializeUBO();
 		CompileShaders();
@@ -379,133 +382,69 @@ public:
 
 	// Global Flecs world
 	
-	bool LoadLevel(const char* gameLevelPath, const char* h2bFolderPath, GW::SYSTEM::GLog log) {
+	// Builds a model (and matching entity) for every mesh in an already parsed level
+	bool LoadLevel(const ESG::GameLevel& gameLevel, const char* h2bFolderPath, GW::SYSTEM::GLog log) {
 		log.LogCategorized("EVENT", "LOADING GAME LEVEL [OBJECT ORIENTED]");
-		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
-		flecs::entity playerEntity;
-		Model playerModel;
 		UnloadLevel(); // clear previous level data if there is any
-		GW::SYSTEM::GFile file;
-		file.Create();
-		if (-file.OpenTextRead(gameLevelPath)) {
-			log.LogCategorized("ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
-			return false;
-		}
-		char linebuffer[1024];
-			int nameIndex = 0;
-		while (+file.ReadLine(linebuffer, 1024, '\n')) {
-				 nameIndex += 1;
-			if (linebuffer[0] == '\0')
-				break;
-			if (std::strcmp(linebuffer, "MESH") == 0) {
-				Model newModel;
-				file.ReadLine(linebuffer, 1024, '\n');
-				log.LogCategorized("INFO", (std::string("Model Detected: ") + linebuffer).c_str());
-				newModel.SetName(linebuffer);
-				std::string modelFile = linebuffer;
-				modelFile = modelFile.substr(0, modelFile.find_last_of("\n"));
-				std::string anvil = "anvil_low";
-				//if (modelFile != anvil) { modelFile += nameIndex; }
-				char* modelName = modelFile.data();
-				
-
-
-				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
-						&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-						&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-				log.LogCategorized("INFO", loc.c_str());
-
-				auto entity = ecs->entity()
-					.set_name(modelName)
-					.set<ESG::Position>({ transform.row4 })
-					.set<ESG::Orientation>({ transform });
-
-				std::cout << "Entity: " << entity.name() << std::endl;
-				entVec.push_back(entity);
-
-				log.LogCategorized("MESSAGE", "Begin Importing .H2B File Data.");
-				
-				modelFile = modelFile.substr(0, modelFile.find_first_of("."));
-
-				modelFile += ".h2b";
-
-				modelFile = std::string(h2bFolderPath) + "/" + modelFile;
-				newModel.SetWorldMatrix(transform);
-				if (newModel.LoadModelDataFromDisk(modelFile.c_str())) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					if (std::strcmp(linebuffer, "TEXTURE") == 0) {
-						file.ReadLine(linebuffer, 1024, '\n');
-						std::string textureFile = linebuffer;
-						if (newModel.LoadTextureFromFile(textureFile.c_str())) {
-							allObjectsInLevel.push_back(std::move(newModel));
-							log.LogCategorized("INFO", (std::string("Texture Loaded: ") + textureFile).c_str());
-						}
-						else {
-							log.LogCategorized("ERROR", (std::string("Texture Not Found: ") + textureFile).c_str());
-						}
+		for (const ESG::GameLevel::Mesh& mesh : gameLevel.GetMeshes()) {
+			Model newModel;
+			newModel.SetName(mesh.blenderName);
+			const GW::MATH::GMATRIXF& transform = mesh.transform;
+			std::string loc = "Location: X ";
+			loc += std::to_string(transform.row4.x) + " Y " +
+				std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
+			log.LogCategorized("INFO", loc.c_str());
+
+			auto entity = ecs->entity()
+				.set_name(mesh.blenderName.c_str())
+				.set<ESG::Position>({ transform.row4 })
+				.set<ESG::Orientation>({ transform });
+
+			std::cout << "Entity: " << entity.name() << std::endl;
+			entVec.push_back(entity);
+
+			log.LogCategorized("MESSAGE", "Begin Importing .H2B File Data.");
+			std::string modelFile = std::string(h2bFolderPath) + "/" + mesh.modelFile;
+			newModel.SetWorldMatrix(transform);
+			if (newModel.LoadModelDataFromDisk(modelFile.c_str())) {
+				if (mesh.texturePath.empty() == false) {
+					if (newModel.LoadTextureFromFile(mesh.texturePath.c_str())) {
+						allObjectsInLevel.push_back(std::move(newModel));
+						log.LogCategorized("INFO", (std::string("Texture Loaded: ") + mesh.texturePath).c_str());
 					}
 					else {
-						log.LogCategorized("ERROR", "Texture information missing in game level file.");
+						log.LogCategorized("ERROR", (std::string("Texture Not Found: ") + mesh.texturePath).c_str());
 					}
-					log.LogCategorized("INFO", (std::string("H2B Imported: ") + modelFile).c_str());
 				}
 				else {
-					log.LogCategorized("ERROR", (std::string("H2B Not Found: ") + modelFile).c_str());
-					log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
+					log.LogCategorized("ERROR", "Texture information missing in game level file.");
 				}
-				log.LogCategorized("MESSAGE", "Importing of .H2B File Data Complete.");
+				log.LogCategorized("INFO", (std::string("H2B Imported: ") + modelFile).c_str());
 			}
-			else if (std::strcmp(linebuffer, "LIGHT") == 0) {
-				file.ReadLine(linebuffer, 1024, '\n'); // Read the type
-				std::string lightType = linebuffer;
-
-				if (lightType == "SUN") {
-					Light sunLight;
-					sunLight.type = "SUN";
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the color
-					std::sscanf(linebuffer, "Color: %f %f %f", &sunLight.color.x, &sunLight.color.y, &sunLight.color.z);
-					sunLight.color.w = 1.0f;
-
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the direction
-					std::sscanf(linebuffer, "Direction: %f %f %f", &sunLight.transform.row3.x, &sunLight.transform.row3.y, &sunLight.transform.row3.z);
-
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the energy
-					std::sscanf(linebuffer, "Energy: %f", &sunLight.energy);
-
-					sunDirection = sunLight.transform.row3;
-					sunColor = sunLight.color;
-					uboData.sunColor = sunColor;
-					uboData.sunDirection = sunDirection;
-
-					lights.push_back(sunLight);
-					log.LogCategorized("INFO", "Sun data parsed successfully.");
-				}
-				else if (lightType == "POINT") {
-					Light pointLight;
-					pointLight.type = "POINT";
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the color
-					std::sscanf(linebuffer, "Color: %f %f %f", &pointLight.color.x, &pointLight.color.y, &pointLight.color.z);
-					pointLight.color.w = 1.0f;
-
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the position
-					std::sscanf(linebuffer, "Position: %f %f %f", &pointLight.transform.row4.x, &pointLight.transform.row4.y, &pointLight.transform.row4.z);
-
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the energy
-					std::sscanf(linebuffer, "Energy: %f", &pointLight.energy);
-
-					lights.push_back(pointLight);
-					log.LogCategorized("INFO", "Point light data parsed successfully.");
-				}
+			else {
+				log.LogCategorized("ERROR", (std::string("H2B Not Found: ") + modelFile).c_str());
+				log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
 			}
+			log.LogCategorized("MESSAGE", "Importing of .H2B File Data Complete.");
+		}
+		for (const ESG::GameLevel::Light& light : gameLevel.GetLights()) {
+			Light levelLight;
+			levelLight.type = light.type;
+			levelLight.color = light.color;
+			levelLight.energy = light.energy;
+			levelLight.transform = GW::MATH::GIdentityMatrixF;
+			if (light.type == "SUN") {
+				levelLight.transform.row3 = light.direction;
+				sunDirection = light.direction;
+				sunColor = light.color;
+				uboData.sunColor = sunColor;
+				uboData.sunDirection = sunDirection;
+			}
+			else {
+				levelLight.transform.row4 = light.position;
+			}
+			lights.push_back(levelLight);
 		}
-		log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
 		log.LogCategorized("EVENT", "GAME LEVEL WAS LOADED TO CPU [OBJECT ORIENTED]");
 		PrintEntities(log);
 		return true;
@@ -565,9 +504,19 @@ public:
 	}
 
 
-	void UpdateAndRender(float deltaTime) {
-		ecs->progress(deltaTime);
+	// Blends a model's position between the last two simulation ticks when the gameplay world drives it
+	bool InterpolateSimulatedPosition(const ESG::RenderSnapshot& snapshot, const std::string& modelName,
+		float alpha, GW::MATH::GVECTORF& outPosition) {
+		const ESG::RenderInstance* simulated = snapshot.Find(modelName);
+		if (simulated == nullptr)
+			return false;
+		GW::MATH::GVector::LerpF(simulated->previousPosition, simulated->currentPosition, alpha, outPosition);
+		outPosition.w = 1;
+		return true;
+	}
 
+	// snapshot is the latest finished simulation tick, alpha is how far past it this frame is drawn
+	void UpdateAndRender(const ESG::RenderSnapshot& snapshot, float alpha) {
 		// Temporary list to store updated models
 		std::vector<Model> updatedModels;
 
@@ -587,6 +536,7 @@ public:
 					if (pos && orient) {
 						GW::MATH::GMATRIXF worldMatrix = orient->value;
 						worldMatrix.row4 = pos->value; // Set position in the world matrix
+						InterpolateSimulatedPosition(snapshot, model.GetName(), alpha, worldMatrix.row4);
 						model.SetWorldMatrix(worldMatrix);
 
 						for (int i = 0; i < 4; ++i) {
@@ -0,0 +1,128 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+using namespace ESG; // Example Space Game
+
+bool ESG::Profiler::Init(std::shared_ptr<flecs::world> _game,
+	std::weak_ptr<const GameConfig> _gameConfig)
+{
+	game = _game;
+	std::shared_ptr<const GameConfig> readCfg = _gameConfig.lock();
+	enabled = (*readCfg).at("Profiler").at("enabled").as<bool>();
+	window = (*readCfg).at("Profiler").at("window").as<unsigned>();
+	csvPath = (*readCfg).at("Profiler").at("csv").as<std::string>();
+	if (window == 0)
+		window = 1;
+	if (enabled == false)
+		return true;
+	// flecs only tracks time per system when asked to
+	ecs_measure_system_time(game->c_ptr(), true);
+	systems = game->filter_builder<>().term(flecs::System).build();
+	scratch = std::make_unique<ecs_system_stats_t>();
+	return true;
+}
+
+void ESG::Profiler::Record(const std::string& name, double milliseconds)
+{
+	if (enabled == false)
+		return;
+	std::lock_guard<std::mutex> lock(tracksLock);
+	Track& track = tracks[name];
+	if (track.samples.size() < window)
+		track.samples.push_back(static_cast<float>(milliseconds));
+	else
+		track.samples[track.next] = static_cast<float>(milliseconds);
+	track.next = (track.next + 1) % window;
+	++track.count;
+	track.totalMs += milliseconds;
+}
+
+void ESG::Profiler::SampleSystems()
+{
+	if (enabled == false || game == nullptr)
+		return;
+	// systems are grouped under the phase they run in (OnLoad, PreUpdate, OnUpdate...)
+	std::map<std::string, double> phaseMs;
+	systems.each([this, &phaseMs](flecs::entity system) {
+		*scratch = {};
+		if (ecs_system_stats_get(game->c_ptr(), system.id(), scratch.get()) == false)
+			return;
+		// flecs gives the running total, the difference is this tick
+		double total = scratch->time_spent.counter.value[scratch->query.t];
+		double& last = lastSystemTime[system.id()];
+		double ms = (total - last) * 1000.0;
+		last = total;
+
+		std::string name = system.name().c_str();
+		if (name.empty())
+			name = "#" + std::to_string(system.id());
+		Record("System: " + name, ms);
+
+		flecs::entity phase = system.target(flecs::DependsOn);
+		if (phase.is_valid())
+			phaseMs["Phase: " + std::string(phase.name().c_str())] += ms;
+		});
+	for (auto& phase : phaseMs)
+		Record(phase.first, phase.second);
+}
+
+float ESG::Profiler::Percentile(std::vector<float> samples, float percentile)
+{
+	if (samples.empty())
+		return 0;
+	size_t rank = static_cast<size_t>(percentile * (samples.size() - 1) + 0.5f);
+	std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+	return samples[rank];
+}
+
+void ESG::Profiler::Print(std::ostream& out)
+{
+	std::lock_guard<std::mutex> lock(tracksLock);
+	out << std::left << std::setw(32) << "Section" << std::right << std::setw(10) << "samples"
+		<< std::setw(10) << "mean ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+		<< std::setw(10) << "p99 ms" << std::endl;
+	std::ios::fmtflags oldFlags = out.flags();
+	for (auto& entry : tracks) {
+		const Track& track = entry.second;
+		out << std::left << std::setw(32) << entry.first << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << track.count
+			<< std::setw(10) << track.totalMs / track.count
+			<< std::setw(10) << Percentile(track.samples, 0.50f)
+			<< std::setw(10) << Percentile(track.samples, 0.95f)
+			<< std::setw(10) << Percentile(track.samples, 0.99f) << std::endl;
+		out.flags(oldFlags);
+	}
+}
+
+bool ESG::Profiler::WriteCSV(const std::string& path)
+{
+	std::ofstream csv(path);
+	if (csv.is_open() == false) {
+		std::cerr << "Failed to write profile to " << path << std::endl;
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(tracksLock);
+	// percentiles only cover the last "window" samples, mean covers the whole run
+	csv << "section,samples,mean_ms,p50_ms,p95_ms,p99_ms\n";
+	for (auto& entry : tracks) {
+		const Track& track = entry.second;
+		csv << '"' << entry.first << "\"," << track.count << ','
+			<< track.totalMs / track.count << ','
+			<< Percentile(track.samples, 0.50f) << ','
+			<< Percentile(track.samples, 0.95f) << ','
+			<< Percentile(track.samples, 0.99f) << '\n';
+	}
+	std::cout << "Profile written to " << path << std::endl;
+	return true;
+}
+
+bool ESG::Profiler::Shutdown()
+{
+	bool written = true;
+	if (enabled && csvPath.empty() == false)
+		written = WriteCSV(csvPath);
+	game.reset();
+	return written;
+}
@@ -0,0 +1,74 @@
+// The profiler keeps rolling timing histograms for flecs systems, phases and any other named section
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Contains our global game settings
+#include "../GameConfig.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// example space game (avoid name collisions)
+namespace ESG
+{
+	class Profiler
+	{
+		// the last "window" samples of one named section, in milliseconds
+		struct Track {
+			std::vector<float> samples; // ring buffer
+			size_t next = 0; // slot the next sample overwrites
+			unsigned long long count = 0; // samples ever recorded
+			double totalMs = 0; // of every sample ever recorded
+		};
+		std::map<std::string, Track> tracks; // ordered so reports are stable
+		std::mutex tracksLock; // sections are recorded from the simulation and render threads
+		size_t window = 600; // samples kept per track
+		bool enabled = true;
+		std::string csvPath;
+		// shared connection to the main ECS engine
+		std::shared_ptr<flecs::world> game;
+		// every system in the world, sampled after each tick
+		flecs::filter<> systems;
+		// running time_spent per system at the last sample
+		std::map<flecs::entity_t, double> lastSystemTime;
+		// flecs stats are large, keep one around to read systems through
+		std::unique_ptr<ecs_system_stats_t> scratch;
+	public:
+		// times everything between construction and destruction into a track
+		class Scope {
+			Profiler& owner;
+			const char* name;
+			std::chrono::steady_clock::time_point start;
+		public:
+			Scope(Profiler& _owner, const char* _name)
+				: owner(_owner), name(_name), start(std::chrono::steady_clock::now()) {}
+			~Scope() {
+				owner.Record(name, std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - start).count());
+			}
+		};
+
+		// reads [Profiler] settings and turns on flecs system timing
+		bool Init(	std::shared_ptr<flecs::world> _game,
+					std::weak_ptr<const GameConfig> _gameConfig);
+		// add one sample (in milliseconds) to a named track
+		void Record(const std::string& name, double milliseconds);
+		// call once after each ECS progress, records every system and phase for that tick
+		void SampleSystems();
+		// p50/p95/p99 of each track as a table
+		void Print(std::ostream& out);
+		// one row per track, returns false if the file can't be written
+		bool WriteCSV(const std::string& path);
+		// writes the CSV (if configured) and lets go of the ECS
+		bool Shutdown();
+	private:
+		// percentile (0-1) of a copy of the samples
+		static float Percentile(std::vector<float> samples, float percentile);
+	};
+};
+
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+// Tests object bounds against the camera frustum several at a time.
+// Add turns a model's OBB and an instance's world matrix into a world space box, kept as separate arrays of
+// centers and extents so Test can check 8 boxes per plane with AVX, or 4 with SSE, in a handful of instructions.
+// AVX is only used when the compiler targets it (/arch:AVX or -mavx), SSE2 is always there on x64.
+// Defining FRUSTUM_CULL_WIDTH as 1 before including this forces the plain loop, the tests build it both ways.
+
+#include <cmath>
+#include <vector>
+#if !defined(FRUSTUM_CULL_WIDTH)
+#if defined(__AVX__)
+#define FRUSTUM_CULL_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULL_WIDTH 4
+#else
+#define FRUSTUM_CULL_WIDTH 1
+#endif
+#endif
+#if FRUSTUM_CULL_WIDTH == 8
+#include <immintrin.h>
+#elif FRUSTUM_CULL_WIDTH == 4
+#include <emmintrin.h>
+#endif
+
+class FrustumCuller {
+	// a, b, c, d of each plane, a point is inside when ax + by + cz + d >= 0 for all six
+	float planes[6][4] = {};
+	// world space boxes, padded to a whole batch
+	std::vector<float> centerX, centerY, centerZ, extentX, extentY, extentZ;
+	size_t count = 0;
+	size_t visibleCount = 0;
+
+	void Reserve(size_t boxes) {
+		size_t padded = (boxes + FRUSTUM_CULL_WIDTH - 1) / FRUSTUM_CULL_WIDTH * FRUSTUM_CULL_WIDTH;
+		if (centerX.size() >= padded)
+			return;
+		padded = padded > centerX.size() * 2 ? padded : centerX.size() * 2;
+		for (std::vector<float>* lane : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+			lane->resize(padded, 0.0f);
+	}
+public:
+	// Pulls the planes out of view * projection (row vectors, the way GMatrix multiplies them)
+	void SetViewProjection(const GW::MATH::GMATRIXF& viewProjection) {
+		const float* m = viewProjection.data;
+		// column c of the matrix is m[c], m[4 + c], m[8 + c], m[12 + c]. -w <= x, y, z <= w in clip space.
+		for (int axis = 0; axis < 3; ++axis) {
+			for (int row = 0; row < 4; ++row) {
+				planes[axis * 2][row] = m[row * 4 + 3] + m[row * 4 + axis];
+				planes[axis * 2 + 1][row] = m[row * 4 + 3] - m[row * 4 + axis];
+			}
+		}
+	}
+
+	void Clear() {
+		count = 0;
+	}
+	// Adds the world space box around bounds placed by toWorld, boxes are tested in the order they're added
+	void Add(const GW::MATH::GOBBF& bounds, const GW::MATH::GMATRIXF& toWorld) {
+		Reserve(count + 1);
+		// rotation of the OBB itself is left out, ComputeOBB never sets one
+#if FRUSTUM_CULL_WIDTH > 1
+		__m128 row0 = _mm_loadu_ps(&toWorld.data[0]);
+		__m128 row1 = _mm_loadu_ps(&toWorld.data[4]);
+		__m128 row2 = _mm_loadu_ps(&toWorld.data[8]);
+		__m128 row3 = _mm_loadu_ps(&toWorld.data[12]);
+		const __m128 noSign = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128 center = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(bounds.center.x), row0), _mm_mul_ps(_mm_set1_ps(bounds.center.y), row1)),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(bounds.center.z), row2), row3));
+		// half size along each world axis of the box the rotated and scaled extents fit in
+		__m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(bounds.extent.x), _mm_and_ps(row0, noSign)),
+			_mm_mul_ps(_mm_set1_ps(bounds.extent.y), _mm_and_ps(row1, noSign))), _mm_mul_ps(_mm_set1_ps(bounds.extent.z), _mm_and_ps(row2, noSign)));
+		alignas(16) float c[4], e[4];
+		_mm_store_ps(c, center);
+		_mm_store_ps(e, extent);
+#else
+		const float* m = toWorld.data;
+		float c[3], e[3];
+		for (int axis = 0; axis < 3; ++axis) {
+			c[axis] = bounds.center.x * m[axis] + bounds.center.y * m[4 + axis] + bounds.center.z * m[8 + axis] + m[12 + axis];
+			e[axis] = bounds.extent.x * std::fabs(m[axis]) + bounds.extent.y * std::fabs(m[4 + axis]) + bounds.extent.z * std::fabs(m[8 + axis]);
+		}
+#endif
+		centerX[count] = c[0];
+		centerY[count] = c[1];
+		centerZ[count] = c[2];
+		extentX[count] = e[0];
+		extentY[count] = e[1];
+		extentZ[count] = e[2];
+		++count;
+	}
+
+	// Sets visible[i] to 1 for every box added that is at least partly inside the frustum, 0 otherwise
+	void Test(std::vector<unsigned char>& visible) {
+		visible.resize(count);
+		visibleCount = 0;
+		for (size_t first = 0; first < count; first += FRUSTUM_CULL_WIDTH) {
+#if FRUSTUM_CULL_WIDTH == 8
+			__m256 cx = _mm256_loadu_ps(&centerX[first]), cy = _mm256_loadu_ps(&centerY[first]), cz = _mm256_loadu_ps(&centerZ[first]);
+			__m256 ex = _mm256_loadu_ps(&extentX[first]), ey = _mm256_loadu_ps(&extentY[first]), ez = _mm256_loadu_ps(&extentZ[first]);
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const float* plane : planes) {
+				// distance of the center plus how far the box reaches toward the plane's normal
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane[0])), _mm256_mul_ps(cy, _mm256_set1_ps(plane[1]))),
+					_mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane[2])), _mm256_set1_ps(plane[3])));
+				__m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::fabs(plane[0]))), _mm256_mul_ps(ey, _mm256_set1_ps(std::fabs(plane[1])))),
+					_mm256_mul_ps(ez, _mm256_set1_ps(std::fabs(plane[2]))));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			int mask = _mm256_movemask_ps(inside);
+#elif FRUSTUM_CULL_WIDTH == 4
+			__m128 cx = _mm_loadu_ps(&centerX[first]), cy = _mm_loadu_ps(&centerY[first]), cz = _mm_loadu_ps(&centerZ[first]);
+			__m128 ex = _mm_loadu_ps(&extentX[first]), ey = _mm_loadu_ps(&extentY[first]), ez = _mm_loadu_ps(&extentZ[first]);
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const float* plane : planes) {
+				// distance of the center plus how far the box reaches toward the plane's normal
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane[0])), _mm_mul_ps(cy, _mm_set1_ps(plane[1]))),
+					_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+				__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::fabs(plane[0]))), _mm_mul_ps(ey, _mm_set1_ps(std::fabs(plane[1])))),
+					_mm_mul_ps(ez, _mm_set1_ps(std::fabs(plane[2]))));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+			}
+			int mask = _mm_movemask_ps(inside);
+#else
+			int mask = 1;
+			for (const float* plane : planes) {
+				float distance = centerX[first] * plane[0] + centerY[first] * plane[1] + centerZ[first] * plane[2] + plane[3];
+				float reach = extentX[first] * std::fabs(plane[0]) + extentY[first] * std::fabs(plane[1]) + extentZ[first] * std::fabs(plane[2]);
+				if (distance + reach < 0.0f)
+					mask = 0;
+			}
+#endif
+			// lanes past count are padding
+			for (size_t lane = 0; lane < FRUSTUM_CULL_WIDTH && first + lane < count; ++lane) {
+				visible[first + lane] = (mask >> lane) & 1;
+				visibleCount += visible[first + lane];
+			}
+		}
+	}
+
+	// boxes the last Test was given and how many of them were inside
+	size_t TestedCount() const {
+		return count;
+	}
+	size_t VisibleCount() const {
+		return visibleCount;
+	}
+};
@@ -0,0 +1,135 @@
+#pragma once
+// A .lvlb file is a GameLevel*.txt cooked ahead of time by the LevelCooker tool.
+// Loading one is a memory map and some bounds checks instead of a line by line text parse.
+
+#include "MappedFile.h"
+#include <string>
+
+namespace LVLB {
+
+	// bump VERSION whenever a struct below changes, older files are then ignored until re-cooked
+	constexpr char MAGIC[4] = { 'L', 'V', 'L', 'B' };
+	constexpr unsigned VERSION = 1;
+	constexpr char EXTENSION[] = ".lvlb"; // GameLevel_1.txt -> GameLevel_1.lvlb
+	constexpr unsigned NO_STRING = 0xFFFFFFFF;
+	constexpr unsigned OBJECT_HAS_BOUNDS = 1;
+	constexpr unsigned SECTION_ALIGNMENT = 16;
+
+#pragma pack(push,1)
+	struct HEADER {
+		char magic[4];
+		unsigned version;
+		unsigned fileSize; // catches truncated copies
+		unsigned objectCount;
+		unsigned lightCount;
+		unsigned stringBytes;
+		// byte offsets from the start of the file, each SECTION_ALIGNMENT aligned
+		unsigned objectOffset; // OBJECT[objectCount]
+		unsigned transformOffset; // MATRIX[objectCount]
+		unsigned boundsOffset; // BOUNDS[objectCount]
+		unsigned lightOffset; // LIGHT[lightCount]
+		unsigned stringOffset; // null terminated strings, stringBytes long
+	};
+	struct MATRIX { // same layout as GW::MATH::GMATRIXF
+		float data[16];
+	};
+	struct BOUNDS { // same layout as GW::MATH2D::GVECTOR3F[8]: LBN, LTN, LTF, LBF, RBN, RTN, RTF, RBF
+		float corners[8][3];
+	};
+	struct OBJECT { // one MESH entry, the strings are offsets into the string table
+		unsigned blenderName;
+		unsigned modelFile; // .h2b the object uses (ex: Wall_Cube.h2b)
+		unsigned texturePath; // NO_STRING if the entry had no TEXTURE
+		unsigned flags; // OBJECT_HAS_BOUNDS
+	};
+	struct LIGHT { // one LIGHT entry the exporter gave a type
+		unsigned type; // string offset ("SUN")
+		float color[4];
+		float direction[4];
+		float position[4];
+		float energy;
+	};
+#pragma pack(pop)
+
+	// A mapped .lvlb, every array points straight into the file
+	class Level {
+		MappedFile file;
+		const HEADER* header = nullptr;
+
+		template<typename T>
+		const T* Section(unsigned offset) const {
+			return reinterpret_cast<const T*>(file.Data() + offset);
+		}
+		bool SectionFits(unsigned offset, unsigned count, size_t stride) const {
+			return offset % SECTION_ALIGNMENT == 0 && offset <= file.Size() &&
+				count <= (file.Size() - offset) / stride;
+		}
+		bool StringFits(unsigned offset, bool optional) const {
+			return (optional && offset == NO_STRING) || offset < header->stringBytes;
+		}
+	public:
+		// Maps a cooked level, false if it's missing, truncated or from another VERSION
+		bool Open(const char* lvlbPath) {
+			Close();
+			if (file.Open(lvlbPath) == false)
+				return false;
+			header = reinterpret_cast<const HEADER*>(file.Data());
+			bool valid = file.Size() >= sizeof(HEADER) &&
+				header->magic[0] == MAGIC[0] && header->magic[1] == MAGIC[1] &&
+				header->magic[2] == MAGIC[2] && header->magic[3] == MAGIC[3] &&
+				header->version == VERSION && header->fileSize == file.Size() &&
+				SectionFits(header->objectOffset, header->objectCount, sizeof(OBJECT)) &&
+				SectionFits(header->transformOffset, header->objectCount, sizeof(MATRIX)) &&
+				SectionFits(header->boundsOffset, header->objectCount, sizeof(BOUNDS)) &&
+				SectionFits(header->lightOffset, header->lightCount, sizeof(LIGHT)) &&
+				SectionFits(header->stringOffset, header->stringBytes, 1) &&
+				header->stringBytes > 0 &&
+				Section<char>(header->stringOffset)[header->stringBytes - 1] == '\0';
+			// strings are read without copying so every reference has to land inside the table
+			for (unsigned i = 0; valid && i < header->objectCount; ++i) {
+				const OBJECT& object = Objects()[i];
+				valid = StringFits(object.blenderName, false) && StringFits(object.modelFile, false) &&
+					StringFits(object.texturePath, true);
+			}
+			for (unsigned i = 0; valid && i < header->lightCount; ++i)
+				valid = StringFits(Lights()[i].type, false);
+			if (valid == false)
+				Close();
+			return valid;
+		}
+
+		// Maps the .lvlb cooked from textPath, false if there isn't one or the text has been edited since
+		bool OpenCooked(const char* textPath) {
+			std::string cookedPath = CookedPath(textPath, EXTENSION);
+			return IsCookedFileCurrent(cookedPath.c_str(), textPath) && Open(cookedPath.c_str());
+		}
+
+		void Close() {
+			file.Close();
+			header = nullptr;
+		}
+
+		unsigned ObjectCount() const {
+			return header ? header->objectCount : 0;
+		}
+		unsigned LightCount() const {
+			return header ? header->lightCount : 0;
+		}
+		const OBJECT* Objects() const {
+			return Section<OBJECT>(header->objectOffset);
+		}
+		const MATRIX* Transforms() const {
+			return Section<MATRIX>(header->transformOffset);
+		}
+		const BOUNDS* Bounds() const {
+			return Section<BOUNDS>(header->boundsOffset);
+		}
+		const LIGHT* Lights() const {
+			return Section<LIGHT>(header->lightOffset);
+		}
+		// nullptr for NO_STRING
+		const char* String(unsigned offset) const {
+			return offset == NO_STRING ? nullptr : Section<char>(header->stringOffset) + offset;
+		}
+	};
+}
@@ -0,0 +1,130 @@
+// Offline tool that cooks GameLevel*.txt files into the .lvlb format the game memory maps on load.
+// usage: LevelCooker GameLevel.txt [GameLevel_1.txt ...]
+// Each .lvlb is written next to the text it came from.
+
+#include "LevelBinary.h"
+#include "LevelTextParser.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+// everything read from one level text file before it's laid out
+struct CookedLevel {
+	std::vector<LVLB::OBJECT> objects;
+	std::vector<LVLB::MATRIX> transforms;
+	std::vector<LVLB::BOUNDS> bounds;
+	std::vector<LVLB::LIGHT> lights;
+	std::string strings; // string table, null separated
+	std::map<std::string, unsigned> stringOffsets; // shared strings are only stored once
+
+	unsigned AddString(const std::string& value) {
+		auto found = stringOffsets.find(value);
+		if (found != stringOffsets.end())
+			return found->second;
+		unsigned offset = static_cast<unsigned>(strings.size());
+		strings.append(value);
+		strings.push_back('\0');
+		stringOffsets.emplace(value, offset);
+		return offset;
+	}
+};
+
+// Reads the text through the same parser the game falls back to, so both always agree
+bool ReadLevelText(const char* textPath, CookedLevel& out) {
+	LevelText::Parser parser;
+	if (parser.Load(textPath) == false) {
+		std::cerr << "Game level not found: " << textPath << std::endl;
+		return false;
+	}
+	parser.Parse([&out](const LevelText::MESH& mesh) {
+		LVLB::OBJECT object = {};
+		object.blenderName = out.AddString(std::string(mesh.blenderName));
+		object.modelFile = out.AddString(std::string(mesh.ModelName()) + ".h2b");
+		object.texturePath = mesh.texturePath.empty() ? LVLB::NO_STRING : out.AddString(std::string(mesh.texturePath));
+		object.flags = mesh.hasBounds ? LVLB::OBJECT_HAS_BOUNDS : 0;
+		LVLB::MATRIX transform;
+		std::memcpy(transform.data, mesh.transform, sizeof(transform.data));
+		LVLB::BOUNDS bounds;
+		std::memcpy(bounds.corners, mesh.bounds, sizeof(bounds.corners));
+		out.objects.push_back(object);
+		out.transforms.push_back(transform);
+		out.bounds.push_back(bounds);
+	}, [&out](const LevelText::LIGHT& light) {
+		LVLB::LIGHT add = {};
+		add.type = out.AddString(std::string(light.type));
+		std::memcpy(add.color, light.color, sizeof(light.color));
+		std::memcpy(add.direction, light.direction, sizeof(light.direction));
+		add.color[3] = 1.0f;
+		out.lights.push_back(add);
+	});
+	if (out.strings.empty())
+		out.AddString(""); // the loader expects a terminated table even for an empty level
+	return true;
+}
+
+unsigned AlignSection(unsigned offset) {
+	return (offset + LVLB::SECTION_ALIGNMENT - 1) / LVLB::SECTION_ALIGNMENT * LVLB::SECTION_ALIGNMENT;
+}
+
+bool WriteLevelBinary(const char* lvlbPath, const CookedLevel& level) {
+	LVLB::HEADER header = {};
+	std::memcpy(header.magic, LVLB::MAGIC, 4);
+	header.version = LVLB::VERSION;
+	header.objectCount = static_cast<unsigned>(level.objects.size());
+	header.lightCount = static_cast<unsigned>(level.lights.size());
+	header.stringBytes = static_cast<unsigned>(level.strings.size());
+	header.objectOffset = AlignSection(sizeof(LVLB::HEADER));
+	header.transformOffset = AlignSection(header.objectOffset + header.objectCount * sizeof(LVLB::OBJECT));
+	header.boundsOffset = AlignSection(header.transformOffset + header.objectCount * sizeof(LVLB::MATRIX));
+	header.lightOffset = AlignSection(header.boundsOffset + header.objectCount * sizeof(LVLB::BOUNDS));
+	header.stringOffset = AlignSection(header.lightOffset + header.lightCount * sizeof(LVLB::LIGHT));
+	header.fileSize = header.stringOffset + header.stringBytes;
+
+	// lay the whole file out in memory so it goes to disk in one write
+	std::vector<char> image(header.fileSize, 0);
+	std::memcpy(image.data(), &header, sizeof(header));
+	if (header.objectCount > 0) {
+		std::memcpy(image.data() + header.objectOffset, level.objects.data(), level.objects.size() * sizeof(LVLB::OBJECT));
+		std::memcpy(image.data() + header.transformOffset, level.transforms.data(), level.transforms.size() * sizeof(LVLB::MATRIX));
+		std::memcpy(image.data() + header.boundsOffset, level.bounds.data(), level.bounds.size() * sizeof(LVLB::BOUNDS));
+	}
+	if (header.lightCount > 0)
+		std::memcpy(image.data() + header.lightOffset, level.lights.data(), level.lights.size() * sizeof(LVLB::LIGHT));
+	std::memcpy(image.data() + header.stringOffset, level.strings.data(), level.strings.size());
+
+	std::ofstream file(lvlbPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (file.is_open() == false) {
+		std::cerr << "Unable to write: " << lvlbPath << std::endl;
+		return false;
+	}
+	file.write(image.data(), image.size());
+	return file.good();
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage: LevelCooker GameLevel.txt [GameLevel_1.txt ...]" << std::endl;
+		return 1;
+	}
+	int failures = 0;
+	for (int i = 1; i < argc; ++i) {
+		CookedLevel level;
+		std::string lvlbPath = CookedPath(argv[i], LVLB::EXTENSION);
+		if (ReadLevelText(argv[i], level) == false || WriteLevelBinary(lvlbPath.c_str(), level) == false) {
+			++failures;
+			continue;
+		}
+		// read it back the same way the game will so a bad cook fails here instead of at load
+		LVLB::Level check;
+		if (check.Open(lvlbPath.c_str()) == false) {
+			std::cerr << "Cooked level failed validation: " << lvlbPath << std::endl;
+			++failures;
+			continue;
+		}
+		std::cout << "Cooked " << argv[i] << " -> " << lvlbPath << " (" << check.ObjectCount() << " objects, "
+			<< check.LightCount() << " lights)" << std::endl;
+	}
+	return failures == 0 ? 0 : 1;
+}
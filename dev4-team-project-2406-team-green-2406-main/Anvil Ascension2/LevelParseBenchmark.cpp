@@ -0,0 +1,190 @@
+// Times the old GFile::ReadLine + sscanf level reader against LevelText::Parser on a synthetically enlarged level.
+// usage: LevelParseBenchmark [GameLevel_1.txt] [meshCount] [runs]
+// The MESH entries of the source level are repeated until there are meshCount of them.
+
+#include "LevelTextParser.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// what both readers produce per MESH, the same data Level_Data keeps
+struct Entry {
+	std::string blenderName;
+	std::string modelFile;
+	std::string textureFilePath;
+	float transform[16];
+	float boundry[8][3];
+};
+
+// GFile::ReadLine without Gateware, a getline into a std::string copied out to the caller's buffer
+struct LineFile {
+	std::ifstream file;
+	std::string line;
+	bool ReadLine(char* out, size_t outSize, char delimiter) {
+		if (!std::getline(file, line, delimiter))
+			return false;
+		std::snprintf(out, outSize, "%s", line.c_str());
+		return true;
+	}
+};
+
+// Level_Data::ReadGameLevel as it was before LevelText::Parser
+bool ReadLineParser(const char* gameLevelPath, std::vector<Entry>& outEntries) {
+	LineFile file;
+	file.file.open(gameLevelPath);
+	if (file.file.is_open() == false)
+		return false;
+	char linebuffer[1024];
+	while (file.ReadLine(linebuffer, 1024, '\n')) {
+		if (linebuffer[0] == '\0')
+			break;
+		if (std::strcmp(linebuffer, "MESH") == 0) {
+			file.ReadLine(linebuffer, 1024, '\n');
+			Entry add = {};
+			add.blenderName = linebuffer;
+			add.modelFile = add.blenderName.substr(0, add.blenderName.find_last_of("."));
+			add.modelFile += ".h2b";
+			for (int i = 0; i < 4; ++i) {
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
+					&add.transform[0 + i * 4], &add.transform[1 + i * 4],
+					&add.transform[2 + i * 4], &add.transform[3 + i * 4]);
+			}
+			file.ReadLine(linebuffer, 1024, '\n');
+			if (std::strcmp(linebuffer, "TEXTURE") == 0) {
+				file.ReadLine(linebuffer, 1024, '\n');
+				add.textureFilePath = linebuffer;
+			}
+			for (int i = 0; i < 8; ++i) {
+				file.ReadLine(linebuffer, 1024, '\n');
+				std::sscanf(linebuffer + 9, "%f, %f, %f",
+					&add.boundry[i][0], &add.boundry[i][1], &add.boundry[i][2]);
+			}
+			outEntries.push_back(add);
+		}
+	}
+	return true;
+}
+
+bool ReadFastParser(LevelText::Parser& parser, const char* gameLevelPath, std::vector<Entry>& outEntries) {
+	if (parser.Load(gameLevelPath) == false)
+		return false;
+	parser.Parse([&outEntries](const LevelText::MESH& mesh) {
+		Entry add;
+		add.blenderName.assign(mesh.blenderName.data(), mesh.blenderName.size());
+		add.modelFile.assign(mesh.ModelName().data(), mesh.ModelName().size()).append(".h2b");
+		add.textureFilePath.assign(mesh.texturePath.data(), mesh.texturePath.size());
+		std::memcpy(add.transform, mesh.transform, sizeof(add.transform));
+		std::memcpy(add.boundry, mesh.bounds, sizeof(add.boundry));
+		outEntries.push_back(std::move(add));
+	}, [](const LevelText::LIGHT&) {});
+	return true;
+}
+
+// Writes the source level's MESH blocks over and over until there are meshCount of them.
+// everyMeshTextured is false if any block has no TEXTURE line.
+bool WriteEnlargedLevel(const char* sourcePath, const char* outPath, unsigned meshCount, bool& everyMeshTextured) {
+	std::ifstream source(sourcePath);
+	if (source.is_open() == false)
+		return false;
+	std::vector<std::string> blocks; // one MESH entry each, every line but the name
+	std::vector<std::string> names;
+	std::string line;
+	bool inMesh = false;
+	while (std::getline(source, line)) {
+		if (line == "MESH") {
+			inMesh = true;
+			blocks.emplace_back();
+			std::getline(source, line);
+			names.push_back(line);
+			continue;
+		}
+		if (line == "LIGHT" || line == "CAMERA")
+			inMesh = false;
+		if (inMesh)
+			blocks.back() += line + "\n";
+	}
+	if (blocks.empty())
+		return false;
+	everyMeshTextured = true;
+	for (const std::string& block : blocks)
+		everyMeshTextured = everyMeshTextured && block.find("\nTEXTURE\n") != std::string::npos;
+	std::ofstream out(outPath, std::ios_base::out | std::ios_base::trunc);
+	out << "# Game Level Exporter v1.3\n";
+	for (unsigned i = 0; i < meshCount; ++i) {
+		size_t block = i % blocks.size();
+		// keep every name unique like blender does, Wall_Cube.020 -> Wall_Cube.020.42
+		out << "MESH\n" << names[block] << "." << i << "\n" << blocks[block];
+	}
+	return out.good();
+}
+
+template<typename Fn>
+double BestOfMs(unsigned runs, Fn&& run) {
+	double best = 1e30;
+	for (unsigned i = 0; i < runs; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		run();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (ms < best)
+			best = ms;
+	}
+	return best;
+}
+
+int main(int argc, char* argv[]) {
+	const char* sourcePath = argc > 1 ? argv[1] : "../GameLevel_1.txt";
+	unsigned meshCount = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 20000;
+	unsigned runs = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 5;
+	const char* enlargedPath = "LevelParseBenchmark.txt";
+	bool everyMeshTextured = false;
+	if (WriteEnlargedLevel(sourcePath, enlargedPath, meshCount, everyMeshTextured) == false) {
+		std::cerr << "Unable to build a level from " << sourcePath << std::endl;
+		return 1;
+	}
+	std::ifstream sized(enlargedPath, std::ios_base::binary | std::ios_base::ate);
+	double megabytes = static_cast<double>(sized.tellg()) / (1024.0 * 1024.0);
+	sized.close();
+
+	std::vector<Entry> oldEntries, newEntries;
+	LevelText::Parser parser; // kept between runs the same way the loaders keep theirs
+	double oldMs = BestOfMs(runs, [&]() {
+		oldEntries.clear();
+		ReadLineParser(enlargedPath, oldEntries);
+	});
+	double newMs = BestOfMs(runs, [&]() {
+		newEntries.clear();
+		ReadFastParser(parser, enlargedPath, newEntries);
+	});
+
+	// both readers have to agree or the timing means nothing. The old reader expects a TEXTURE line after every
+	// matrix, without one it reads the bounds a line late and swallows the next MESH, so it's only a reference
+	// for levels where every MESH has one.
+	bool match = oldEntries.size() == newEntries.size();
+	for (size_t i = 0; match && i < oldEntries.size(); ++i) {
+		match = oldEntries[i].blenderName == newEntries[i].blenderName &&
+			oldEntries[i].modelFile == newEntries[i].modelFile &&
+			oldEntries[i].textureFilePath == newEntries[i].textureFilePath &&
+			std::memcmp(oldEntries[i].transform, newEntries[i].transform, sizeof(Entry::transform)) == 0 &&
+			std::memcmp(oldEntries[i].boundry, newEntries[i].boundry, sizeof(Entry::boundry)) == 0;
+	}
+	std::remove(enlargedPath);
+
+	std::printf("%u MESH entries, %.2f MB, best of %u runs\n", meshCount, megabytes, runs);
+	std::printf("ReadLine + sscanf   %9.2f ms %9.1f MB/s\n", oldMs, megabytes / (oldMs / 1000.0));
+	std::printf("LevelText::Parser   %9.2f ms %9.1f MB/s\n", newMs, megabytes / (newMs / 1000.0));
+	if (everyMeshTextured == false) {
+		// only the entry count can be checked then, every MESH written has to come back
+		bool complete = newEntries.size() == meshCount;
+		std::printf("speedup %.1fx, %zu of %u entries read (the old reader misreads MESH entries without TEXTURE, not compared)\n",
+			oldMs / newMs, newEntries.size(), meshCount);
+		return complete ? 0 : 1;
+	}
+	std::printf("speedup %.1fx, results %s\n", oldMs / newMs, match ? "match" : "DIFFER");
+	return match ? 0 : 1;
+}
@@ -0,0 +1,407 @@
+#pragma once
+// Draws a Level_Data with GPU instancing.
+// Every model's geometry goes up once into a single vertex and index buffer, as 16 byte packed vertices, and each frame the transforms
+// of the objects still alive in the flecs world are packed into one instance buffer grouped by model.
+// Each (model, batch) pair is then one glDrawElementsInstancedBaseVertex covering all of that model's instances,
+// so draw calls follow the number of unique models instead of the number of objects.
+// With GL 4.3 (or GL_ARB_multi_draw_indirect) the draws go through an indirect command buffer instead, one glMultiDrawElementsIndirect per
+// texture binding covers every model that samples it, so a level is a handful of calls however many models it has.
+// Instance matrices and indirect commands are written into persistently mapped rings, nothing waits on glBufferSubData.
+// Objects whose collider is outside the camera frustum are culled before they reach the instance buffer.
+// Render can draw only the models with a Dynamic entity or only the rest, so the static ones can be cached.
+
+// Level_Data comes from load_data_oriented.h, included ahead of this like it is for load_object_oriented.h
+#include "ShaderProgram.h"
+#include "RingBuffer.h"
+#include "FrustumCuller.h"
+#include "TextureCache.h"
+#include "flecs-3.2.0/flecs.h"
+#include "components.h"
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+class Level_Renderer {
+public:
+	// which models a Render draws, a model counts as dynamic if any of its live entities has the Dynamic tag
+	enum PASS {
+		ALL_OBJECTS,
+		STATIC_OBJECTS,
+		DYNAMIC_OBJECTS,
+	};
+private:
+	// one levelInstances entry, everything drawn with the same model and texture
+	struct GROUP {
+		unsigned modelIndex = 0;
+		unsigned transformStart = 0, transformCount = 0; // its slice of levelTransforms
+		unsigned firstInstance = 0, instanceCount = 0; // its slice of this frame's instance buffer
+		TextureCache::TEXTURE* texture = nullptr;
+		bool dynamic = false; // as of the last Render
+	};
+	// one object's entry in the instance buffer. normal holds the columns of the inverse transpose of the
+	// matrix's 3x3 part, made here once per object so the shader doesn't invert a matrix for every vertex.
+	struct INSTANCE {
+		GW::MATH::GMATRIXF world;
+		GW::MATH::GVECTORF normal[3]; // w unused
+	};
+	// the layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+	struct DRAW_COMMAND {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+	ShaderProgram shader;
+	int textureLayer = -1;
+	bool multiDrawIndirect = false; // GL 4.3 or GL_ARB_multi_draw_indirect, found by Create
+	GLuint vao = 0;
+	GLuint vertexBuffer = 0, indexBuffer = 0;
+	RingBuffer instanceRing, commandRing; // this frame's INSTANCEs and indirect commands
+	GLintptr instanceBase = 0; // where this frame's INSTANCEs start in instanceRing
+	std::shared_ptr<Level_Data> level; // read every frame, batches and models are looked up in it
+	std::vector<GROUP> groups;
+	std::vector<GW::MATH::GMATRIXF> transforms; // latest matrix for every levelTransforms slot
+	std::vector<unsigned> aliveFrame; // frame a slot last had a live entity
+	std::vector<unsigned char> dynamicSlot; // its entity had the Dynamic tag
+	std::vector<INSTANCE> instances; // this frame's instance buffer contents
+	std::vector<DRAW_COMMAND> commands; // this frame's indirect buffer contents
+	std::vector<unsigned> order; // groups sorted so ones sharing a texture binding are next to each other
+	FrustumCuller culler;
+	std::vector<unsigned char> visible; // per live object this frame, in the order they were given to culler
+	unsigned frame = 0;
+	bool staticChanged = false; // a group's dynamic flag flipped since the last StaticModelsChanged
+	size_t drawCalls = 0;
+
+	static constexpr GLuint WORLD_ATTRIBUTE = 3; // a mat4 takes 3 through 6, one column each
+	static constexpr GLuint NORMAL_ATTRIBUTE = 7; // a mat3 takes 7 through 9
+
+	// world matrix for a model's packed positions, scales them out of -1 to 1 and moves them to the bounds center
+	// first, the same as Model::UnpackBounds
+	static GW::MATH::GMATRIXF UnpackBounds(const Level_Data::LEVEL_MODEL& model, const GW::MATH::GMATRIXF& toWorld) {
+		GW::MATH::GMATRIXF out;
+		for (int column = 0; column < 4; ++column) {
+			out.data[0 + column] = toWorld.data[0 + column] * model.boundsExtent[0];
+			out.data[4 + column] = toWorld.data[4 + column] * model.boundsExtent[1];
+			out.data[8 + column] = toWorld.data[8 + column] * model.boundsExtent[2];
+			out.data[12 + column] = toWorld.data[12 + column] + model.boundsCenter[0] * toWorld.data[0 + column] +
+				model.boundsCenter[1] * toWorld.data[4 + column] + model.boundsCenter[2] * toWorld.data[8 + column];
+		}
+		return out;
+	}
+	// The normal matrix for world. Its columns in the shader are the rows here, so the inverse transpose is the
+	// cross products of those rows over the determinant, which also keeps normals facing out under mirroring.
+	static INSTANCE MakeInstance(const GW::MATH::GMATRIXF& world) {
+		INSTANCE instance;
+		instance.world = world;
+		const float* r0 = &world.data[0];
+		const float* r1 = &world.data[4];
+		const float* r2 = &world.data[8];
+		const float* rows[3][2] = { { r1, r2 }, { r2, r0 }, { r0, r1 } };
+		for (int c = 0; c < 3; ++c) {
+			const float* a = rows[c][0];
+			const float* b = rows[c][1];
+			instance.normal[c] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0], 0.0f };
+		}
+		float determinant = r0[0] * instance.normal[0].x + r0[1] * instance.normal[0].y + r0[2] * instance.normal[0].z;
+		float scale = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+		for (GW::MATH::GVECTORF& column : instance.normal) {
+			column.x *= scale;
+			column.y *= scale;
+			column.z *= scale;
+		}
+		return instance;
+	}
+
+	// Picks up the latest matrix of every object that still has a flecs entity and works out which groups are dynamic
+	void Sync(flecs::world& world) {
+		// destroyed bricks lose their entity, so only slots something touched this frame are drawn
+		++frame;
+		world.each([this](flecs::entity entity, const ModelTransform& transform) {
+			if (transform.rendererIndex < transforms.size()) {
+				transforms[transform.rendererIndex] = transform.matrix;
+				aliveFrame[transform.rendererIndex] = frame;
+				dynamicSlot[transform.rendererIndex] = entity.has<Dynamic>();
+			}
+		});
+		for (GROUP& group : groups) {
+			bool dynamic = false;
+			for (unsigned i = group.transformStart; i < group.transformStart + group.transformCount; ++i)
+				dynamic = dynamic || (aliveFrame[i] == frame && dynamicSlot[i]);
+			staticChanged = staticChanged || dynamic != group.dynamic;
+			group.dynamic = dynamic;
+		}
+	}
+	// Copies the matrix of every object in pass that still has a flecs entity and is in view into instances,
+	// grouped by model. Groups outside pass are left with no instances.
+	void GatherInstances(flecs::world& world, PASS pass) {
+		Sync(world);
+		// every live object's bounds are tested in one go, then the visible ones are packed in the same order
+		culler.Clear();
+		for (GROUP& group : groups) {
+			if (pass != ALL_OBJECTS && group.dynamic != (pass == DYNAMIC_OBJECTS))
+				continue;
+			const GW::MATH::GOBBF& bounds = level->levelColliders[level->levelModels[group.modelIndex].colliderIndex];
+			for (unsigned i = group.transformStart; i < group.transformStart + group.transformCount; ++i) {
+				if (aliveFrame[i] == frame)
+					culler.Add(bounds, transforms[i]);
+			}
+		}
+		culler.Test(visible);
+		instances.clear();
+		size_t tested = 0;
+		for (GROUP& group : groups) {
+			group.firstInstance = static_cast<unsigned>(instances.size());
+			group.instanceCount = 0;
+			if (pass != ALL_OBJECTS && group.dynamic != (pass == DYNAMIC_OBJECTS))
+				continue;
+			// the bounds scale goes into the normal matrix too, PackVertex scaled the normals to cancel it
+			const Level_Data::LEVEL_MODEL& model = level->levelModels[group.modelIndex];
+			for (unsigned i = group.transformStart; i < group.transformStart + group.transformCount; ++i) {
+				if (aliveFrame[i] == frame && visible[tested++])
+					instances.push_back(MakeInstance(UnpackBounds(model, transforms[i])));
+			}
+			group.instanceCount = static_cast<unsigned>(instances.size()) - group.firstInstance;
+		}
+	}
+	// what a group's texture binds as, equal keys can share one draw
+	std::tuple<GLuint, GLuint, GLint> BindingKey(const GROUP& group) const {
+		const TextureCache::TEXTURE& texture = *group.texture;
+		GLint layer = textureLayer != -1 && texture.ready ? static_cast<GLint>(texture.layer) : -1;
+		return { texture.id, textureLayer != -1 ? texture.array : 0, layer };
+	}
+	void BindTexture(const GROUP& group) {
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, group.texture->id);
+		if (textureLayer != -1) {
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, group.texture->array);
+			shader.Set(textureLayer, std::get<2>(BindingKey(group)));
+			glActiveTexture(GL_TEXTURE0);
+		}
+	}
+	// One glDrawElementsInstancedBaseVertex per (model, batch)
+	void SubmitInstanced() {
+		for (const GROUP& group : groups) {
+			if (group.instanceCount == 0)
+				continue;
+			const Level_Data::LEVEL_MODEL& model = level->levelModels[group.modelIndex];
+			BindTexture(group);
+			PointInstancesAt(group.firstInstance);
+			for (unsigned b = model.batchStart; b < model.batchStart + model.materialCount; ++b) {
+				const H2B::BATCH& batch = level->levelBatches[b];
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, batch.indexCount, GL_UNSIGNED_INT,
+					(void*)(sizeof(unsigned) * (static_cast<size_t>(model.indexStart) + batch.indexOffset)),
+					group.instanceCount, model.vertexStart);
+				++drawCalls;
+			}
+		}
+	}
+	// Every (model, batch) becomes a DRAW_COMMAND, then one glMultiDrawElementsIndirect per texture binding.
+	// baseInstance picks each model's matrices, so the instance attributes stay pointed at the start.
+	void SubmitIndirect() {
+		order.resize(groups.size());
+		for (unsigned g = 0; g < groups.size(); ++g)
+			order[g] = g;
+		std::stable_sort(order.begin(), order.end(), [this](unsigned a, unsigned b) {
+			return BindingKey(groups[a]) < BindingKey(groups[b]);
+		});
+		commands.clear();
+		// each run of groups sharing a binding: its first command and a group to bind from
+		std::vector<std::pair<unsigned, unsigned>> runs;
+		for (unsigned g : order) {
+			const GROUP& group = groups[g];
+			if (group.instanceCount == 0)
+				continue;
+			if (runs.empty() || BindingKey(groups[runs.back().second]) != BindingKey(group))
+				runs.push_back({ static_cast<unsigned>(commands.size()), g });
+			const Level_Data::LEVEL_MODEL& model = level->levelModels[group.modelIndex];
+			for (unsigned b = model.batchStart; b < model.batchStart + model.materialCount; ++b) {
+				const H2B::BATCH& batch = level->levelBatches[b];
+				commands.push_back({ batch.indexCount, group.instanceCount, model.indexStart + batch.indexOffset,
+					static_cast<GLint>(model.vertexStart), group.firstInstance });
+			}
+		}
+		GLintptr commandBase = 0;
+		if (commands.empty() || commandRing.Write(commands.data(), commands.size() * sizeof(DRAW_COMMAND), commandBase) == false)
+			return;
+		commandRing.Flush();
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandRing.Id());
+		PointInstancesAt(0);
+		for (size_t r = 0; r < runs.size(); ++r) {
+			unsigned first = runs[r].first;
+			unsigned last = r + 1 < runs.size() ? runs[r + 1].first : static_cast<unsigned>(commands.size());
+			BindTexture(groups[runs[r].second]);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(commandBase + sizeof(DRAW_COMMAND) * first), last - first, 0);
+			++drawCalls;
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	// the instance attributes start at the group's first INSTANCE when there's no base instance to do it.
+	// instanceRing must be bound to GL_ARRAY_BUFFER, this frame's INSTANCEs sit at instanceBase in it.
+	void PointInstancesAt(unsigned firstInstance) const {
+		GLintptr first = instanceBase + static_cast<GLintptr>(sizeof(INSTANCE)) * firstInstance;
+		for (GLuint column = 0; column < 4; ++column)
+			glVertexAttribPointer(WORLD_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(INSTANCE),
+				(void*)(first + offsetof(INSTANCE, world) + sizeof(GW::MATH::GVECTORF) * column));
+		for (GLuint column = 0; column < 3; ++column)
+			glVertexAttribPointer(NORMAL_ATTRIBUTE + column, 3, GL_FLOAT, GL_FALSE, sizeof(INSTANCE),
+				(void*)(first + offsetof(INSTANCE, normal) + sizeof(GW::MATH::GVECTORF) * column));
+	}
+public:
+	Level_Renderer() = default;
+	Level_Renderer(const Level_Renderer&) = delete;
+	Level_Renderer& operator=(const Level_Renderer&) = delete;
+	~Level_Renderer() {
+		if (vao != 0) {
+			glDeleteVertexArrays(1, &vao);
+			glDeleteBuffers(1, &vertexBuffer);
+			glDeleteBuffers(1, &indexBuffer);
+		}
+	}
+
+	// Builds the instanced shader, false with GetShader().Errors() filled in if it doesn't compile or link
+	bool Create() {
+		if (shader.Create("../Shaders/InstancedVertexShader.glsl", "../Shaders/FragmentShader.glsl") == false)
+			return false;
+		textureLayer = shader.Uniform("textureLayer");
+		// the entry point can load on drivers that don't support it, so the version says whether it's there
+		multiDrawIndirect = glMultiDrawElementsIndirect != nullptr &&
+			(HasOGLVersion(4, 3) || HasOGLExtension("GL_ARB_multi_draw_indirect"));
+		shader.Use();
+		shader.Set(shader.Uniform("texture_diffuse"), 0);
+		shader.Set(shader.Uniform("texture_layers"), 1);
+		return true;
+	}
+	ShaderProgram& GetShader() {
+		return shader;
+	}
+
+	// Sends the combined level geometry to the GPU and acquires each model's texture.
+	// Models without a texture are left out, the same as Level_Objects does.
+	void Upload(std::shared_ptr<Level_Data> levelData, TextureCache& textures) {
+		Unload(textures);
+		level = levelData;
+		if (level == nullptr || level->levelVertices.empty())
+			return;
+		if (vao == 0) {
+			glGenVertexArrays(1, &vao);
+			glGenBuffers(1, &vertexBuffer);
+			glGenBuffers(1, &indexBuffer);
+		}
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, level->levelVertices.size() * sizeof(H2B::PACKED_VERTEX), level->levelVertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, level->levelIndices.size() * sizeof(unsigned), level->levelIndices.data(), GL_STATIC_DRAW);
+		// the shader sees the same vec3/vec2/vec3 as it would from float vertices
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(H2B::PACKED_VERTEX), (void*)offsetof(H2B::PACKED_VERTEX, pos));
+		glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(H2B::PACKED_VERTEX), (void*)offsetof(H2B::PACKED_VERTEX, uv));
+		glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(H2B::PACKED_VERTEX), (void*)offsetof(H2B::PACKED_VERTEX, nrm));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		// world and normal matrices advance once per instance instead of per vertex
+		instanceRing.Reserve(GL_ARRAY_BUFFER, level->levelTransforms.size() * sizeof(INSTANCE), sizeof(INSTANCE));
+		glBindBuffer(GL_ARRAY_BUFFER, instanceRing.Id());
+		instanceBase = 0;
+		PointInstancesAt(0);
+		for (GLuint location = WORLD_ATTRIBUTE; location < NORMAL_ATTRIBUTE + 3; ++location) {
+			glEnableVertexAttribArray(location);
+			glVertexAttribDivisor(location, 1);
+		}
+		glBindVertexArray(0);
+
+		for (const Level_Data::MODEL_INSTANCES& set : level->levelInstances) {
+			const Level_Data::LEVEL_MODEL& model = level->levelModels[set.modelIndex];
+			TextureCache::TEXTURE* texture = model.textureFilePath.empty() ? nullptr : textures.Acquire(model.textureFilePath.c_str());
+			if (texture == nullptr)
+				continue;
+			GROUP& group = groups.emplace_back();
+			group.modelIndex = set.modelIndex;
+			group.transformStart = set.transformStart;
+			group.transformCount = set.transformCount;
+			group.texture = texture;
+		}
+		// at most one command per (model, batch) a frame
+		size_t commandCount = 0;
+		for (const GROUP& group : groups)
+			commandCount += level->levelModels[group.modelIndex].materialCount;
+		commandRing.Reserve(GL_DRAW_INDIRECT_BUFFER, commandCount * sizeof(DRAW_COMMAND), sizeof(GLuint));
+		transforms = level->levelTransforms;
+		aliveFrame.assign(transforms.size(), 0);
+		dynamicSlot.assign(transforms.size(), 0);
+		instances.reserve(transforms.size());
+		frame = 0;
+		staticChanged = true;
+	}
+	void Unload(TextureCache& textures) {
+		for (GROUP& group : groups)
+			textures.Release(group.texture);
+		groups.clear();
+		level = nullptr;
+	}
+	bool IsLoaded() const {
+		return groups.empty() == false;
+	}
+
+	// Draws every object in pass that still has a flecs entity and is in view of viewProjection, at wherever
+	// gameplay has moved it. The shader must be in use with its per frame uniforms and the UBO already set.
+	void Render(flecs::world& world, const GW::MATH::GMATRIXF& viewProjection, PASS pass = ALL_OBJECTS) {
+		drawCalls = 0;
+		if (groups.empty())
+			return;
+		culler.SetViewProjection(viewProjection);
+		GatherInstances(world, pass);
+		instanceRing.BeginFrame();
+		commandRing.BeginFrame();
+		// Upload sized the ring for every object, so this only fails if the section couldn't be mapped.
+		// Nothing is drawn then, instanceBase would still point at an older frame's matrices.
+		bool written = instances.empty() || instanceRing.Write(instances.data(), instances.size() * sizeof(INSTANCE), instanceBase);
+		instanceRing.Flush();
+		if (written) {
+			glBindVertexArray(vao);
+			glBindBuffer(GL_ARRAY_BUFFER, instanceRing.Id());
+			if (multiDrawIndirect)
+				SubmitIndirect();
+			else
+				SubmitInstanced();
+			glBindVertexArray(0);
+		}
+		instanceRing.EndFrame();
+		commandRing.EndFrame();
+	}
+
+	// True when a model has gained its first Dynamic entity or lost its last one since the previous call, so
+	// a STATIC_OBJECTS pass would no longer draw the same models. Call before deciding whether to redraw one.
+	bool StaticModelsChanged(flecs::world& world) {
+		if (groups.empty())
+			return false;
+		Sync(world);
+		bool changed = staticChanged;
+		staticChanged = false;
+		return changed;
+	}
+
+	// draws issued by the last Render, the (model, batch) pairs and objects they covered
+	size_t DrawCallCount() const {
+		return drawCalls;
+	}
+	size_t CommandCount() const {
+		return commands.size();
+	}
+	size_t InstanceCount() const {
+		return instances.size();
+	}
+	// live objects the frustum test left out of the last Render
+	size_t CulledCount() const {
+		return culler.TestedCount() - culler.VisibleCount();
+	}
+	size_t ModelCount() const {
+		return groups.size();
+	}
+	// bytes of instances and commands the last Render wrote for the GPU
+	size_t UploadedBytes() const {
+		return instanceRing.LastFrameBytes() + commandRing.LastFrameBytes();
+	}
+};
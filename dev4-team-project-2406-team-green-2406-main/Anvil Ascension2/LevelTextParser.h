@@ -0,0 +1,140 @@
+#pragma once
+// Reader for the GameLevel*.txt files the blender exporter writes.
+// The whole file goes into one buffer that is kept between loads and every name handed out is a view into it,
+// so once the buffer has grown to fit a level, parsing another one doesn't allocate.
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace LevelText {
+
+	struct MESH {
+		std::string_view blenderName; // unique object name (ex: Wall_Cube.020)
+		std::string_view texturePath; // empty if the entry had no TEXTURE
+		float transform[16]; // same layout as GW::MATH::GMATRIXF
+		float bounds[8][3]; // same layout as GW::MATH2D::GVECTOR3F[8]: LBN, LTN, LTF, LBF, RBN, RTN, RTF, RBF
+		bool hasBounds;
+
+		// blender adds .001 style suffixes to copies, they all share one .h2b (Wall_Cube.020 -> Wall_Cube)
+		std::string_view ModelName() const {
+			return blenderName.substr(0, blenderName.find_last_of('.'));
+		}
+	};
+	struct LIGHT {
+		std::string_view type; // "SUN"
+		float color[3];
+		float direction[3];
+	};
+
+	// Reads count floats separated by spaces, commas or brackets, false if there weren't enough
+	inline bool ReadFloats(std::string_view text, float* out, int count) {
+		const char* next = text.data();
+		const char* end = next + text.size();
+		for (int i = 0; i < count; ++i) {
+			while (next < end && (*next == ' ' || *next == '\t' || *next == ',' ||
+				*next == '(' || *next == ')' || *next == '<' || *next == '>'))
+				++next;
+			std::from_chars_result result = std::from_chars(next, end, out[i]);
+			if (result.ec != std::errc())
+				return false;
+			next = result.ptr;
+		}
+		return true;
+	}
+
+	// Everything after the first "from" character, so "<Matrix 4x4 (" or "Color:" isn't read as a number
+	inline std::string_view After(std::string_view line, char from) {
+		size_t found = line.find(from);
+		return found == std::string_view::npos ? std::string_view() : line.substr(found + 1);
+	}
+
+	class Parser {
+		std::vector<char> buffer; // only ever grows
+		size_t length = 0;
+
+		// splits off the next line with memchr, false at the end of the file
+		static bool NextLine(const char*& next, const char* end, std::string_view& line) {
+			if (next >= end)
+				return false;
+			const char* newline = static_cast<const char*>(std::memchr(next, '\n', end - next));
+			const char* stop = newline ? newline : end;
+			line = std::string_view(next, stop - next);
+			if (line.empty() == false && line.back() == '\r')
+				line.remove_suffix(1); // levels exported on windows
+			next = newline ? newline + 1 : end;
+			return true;
+		}
+	public:
+		// Reads the whole file into the buffer, false if it can't be opened
+		bool Load(const char* gameLevelPath) {
+			length = 0;
+			std::ifstream file(gameLevelPath, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+			if (file.is_open() == false)
+				return false;
+			std::streamoff size = file.tellg();
+			if (size <= 0)
+				return true; // an empty level is still a level
+			if (buffer.size() < static_cast<size_t>(size))
+				buffer.resize(static_cast<size_t>(size));
+			file.seekg(0);
+			file.read(buffer.data(), size);
+			length = static_cast<size_t>(file.gcount());
+			return true;
+		}
+
+		// Calls onMesh(const MESH&) once each MESH entry is complete and onLight(const LIGHT&) for each SUN.
+		// TEXTURE and <Vector blocks belong to the last MESH, an empty line ends the level.
+		// Views are only valid until the next Load.
+		template<typename MeshFn, typename LightFn>
+		void Parse(MeshFn&& onMesh, LightFn&& onLight) const {
+			const char* next = buffer.data();
+			const char* end = next + length;
+			std::string_view line;
+			MESH mesh = {};
+			bool pending = false; // mesh holds an entry that hasn't been handed out
+			while (NextLine(next, end, line) && line.empty() == false) {
+				if (line == "MESH") {
+					if (pending)
+						onMesh(static_cast<const MESH&>(mesh));
+					mesh = {};
+					pending = NextLine(next, end, mesh.blenderName);
+					for (int i = 0; i < 4 && NextLine(next, end, line); ++i)
+						ReadFloats(After(line, '('), mesh.transform + i * 4, 4);
+				}
+				else if (line == "TEXTURE" && pending) {
+					NextLine(next, end, mesh.texturePath);
+				}
+				else if (pending && line.compare(0, 7, "<Vector") == 0) {
+					// eight corners in a row, one per line
+					for (int i = 0; i < 8; ++i) {
+						if (i > 0 && NextLine(next, end, line) == false)
+							break;
+						ReadFloats(After(line, '('), mesh.bounds[i], 3);
+					}
+					mesh.hasBounds = true;
+				}
+				else if (line == "LIGHT") {
+					LIGHT light = {};
+					if (NextLine(next, end, light.type) == false || light.type != "SUN")
+						continue; // camera/named light blocks, only suns are used
+					if (NextLine(next, end, line))
+						ReadFloats(After(line, ':'), light.color, 3);
+					if (NextLine(next, end, line))
+						ReadFloats(After(line, ':'), light.direction, 3);
+					onLight(static_cast<const LIGHT&>(light));
+				}
+			}
+			if (pending)
+				onMesh(static_cast<const MESH&>(mesh));
+		}
+
+		// bytes read by the last Load
+		size_t Size() const {
+			return length;
+		}
+	};
+}
@@ -0,0 +1,184 @@
+#pragma once
+// The mapped file is a read only view of a whole file on disk, pages are only read in when they're touched
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Unmapped when closed or destroyed, moving it keeps the view at the same address
+class MappedFile
+{
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept {
+		*this = static_cast<MappedFile&&>(other);
+	}
+	MappedFile& operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			Close();
+			data = other.data;
+			size = other.size;
+			other.data = nullptr;
+			other.size = 0;
+#if defined(_WIN32)
+			file = other.file;
+			mapping = other.mapping;
+			other.file = INVALID_HANDLE_VALUE;
+			other.mapping = nullptr;
+#endif
+		}
+		return *this;
+	}
+	~MappedFile() {
+		Close();
+	}
+
+	// false if the file is missing or empty
+	bool Open(const char* path) {
+		Close();
+#if defined(_WIN32)
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) == FALSE || fileSize.QuadPart == 0) {
+			Close();
+			return false;
+		}
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			Close();
+			return false;
+		}
+		data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data == nullptr) {
+			Close();
+			return false;
+		}
+		size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0) {
+			close(fd);
+			return false;
+		}
+		void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd); // the mapping keeps its own reference
+		if (view == MAP_FAILED)
+			return false;
+		data = static_cast<const unsigned char*>(view);
+		size = static_cast<size_t>(info.st_size);
+#endif
+		return true;
+	}
+
+	void Close() {
+#if defined(_WIN32)
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data != nullptr)
+			munmap(const_cast<unsigned char*>(data), size);
+#endif
+		data = nullptr;
+		size = 0;
+	}
+
+	bool IsOpen() const {
+		return data != nullptr;
+	}
+	const unsigned char* Data() const {
+		return data;
+	}
+	size_t Size() const {
+		return size;
+	}
+	// 64 bit FNV-1a of the whole file, tells apart assets that were exported twice under different names
+	unsigned long long Hash() const {
+		unsigned long long hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; ++i)
+			hash = (hash ^ data[i]) * 1099511628211ull;
+		return hash;
+	}
+};
+
+// Swaps the extension a cooker writes in: ("Textures/Stone.jpg", ".texb") -> "Textures/Stone.texb"
+inline std::string CookedPath(const char* sourcePath, const char* cookedExtension) {
+	std::string path = sourcePath;
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+		path.erase(dot);
+	return path + cookedExtension;
+}
+
+// True if cookedPath exists and is at least as new as the sourcePath it was cooked from
+inline bool IsCookedFileCurrent(const char* cookedPath, const char* sourcePath) {
+	struct stat sourceInfo, cookedInfo;
+	if (stat(cookedPath, &cookedInfo) != 0)
+		return false;
+	return stat(sourcePath, &sourceInfo) != 0 || sourceInfo.st_mtime <= cookedInfo.st_mtime;
+}
+
+// One spelling per file so caches can key on it: "..\\Models\\.\\Floor.h2b" -> "../Models/Floor.h2b"
+// Windows paths are case insensitive so they're lowered there too
+inline std::string NormalizeAssetPath(const char* path) {
+	std::string out;
+	size_t keep = 0; // leading "../" can't be folded away
+	const char* segment = path;
+	while (true) {
+		const char* stop = segment;
+		while (*stop != '\0' && *stop != '/' && *stop != '\\')
+			++stop;
+		std::string name(segment, stop);
+		if (name == "..") {
+			size_t parent = out.size() > keep ? out.find_last_of('/', out.size() - 2) : std::string::npos;
+			if (out.size() > keep)
+				out.resize(parent == std::string::npos || parent < keep ? keep : parent + 1);
+			else
+				keep = (out += "../").size();
+		}
+		else if (name.empty() == false && name != ".") {
+			out += name;
+			if (*stop != '\0')
+				out += '/';
+		}
+		else if (segment == path && *stop != '\0')
+			out += name.empty() ? "/" : ""; // keeps absolute paths absolute
+		if (*stop == '\0')
+			break;
+		segment = stop + 1;
+	}
+#if defined(_WIN32)
+	for (char& ch : out)
+		if (ch >= 'A' && ch <= 'Z')
+			ch = static_cast<char>(ch - 'A' + 'a');
+#endif
+	return out;
+}
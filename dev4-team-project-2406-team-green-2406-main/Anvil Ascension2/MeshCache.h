@@ -0,0 +1,156 @@
+#pragma once
+// Every level object that uses the same .h2b shares one set of GPU buffers.
+// Meshes are reference counted, the last Release frees the VAO/VBO/IBO.
+
+#include "h2bParser.h"
+#include <list>
+#include <string>
+#include <unordered_map>
+
+class MeshCache {
+public:
+	// GPU side of one .h2b, handed out to every Model that uses it
+	struct MESH {
+		GLuint vao = 0;
+		GLuint vertexBufferObject = 0;
+		GLuint indexBufferObject = 0;
+		unsigned indexCount = 0;
+		GLenum indexType = GL_UNSIGNED_INT;
+		// .h2b2 positions are -1 to 1 inside the model bounds, these scale them back out
+		bool packed = false;
+		float boundsCenter[3] = { 0, 0, 0 };
+		float boundsExtent[3] = { 1, 1, 1 };
+		unsigned references = 0;
+	private:
+		friend class MeshCache;
+		H2B::MappedParser cpuModel; // only held until Upload
+		unsigned long long contentHash = 0;
+		size_t contentSize = 0;
+		std::list<std::string> paths; // every normalized path that resolved to this mesh
+	};
+private:
+	std::list<MESH> meshes; // list so handed out pointers stay put
+	std::unordered_map<std::string, MESH*> byPath;
+	std::unordered_map<unsigned long long, MESH*> byContent;
+
+	static bool Upload(MESH& mesh) {
+		const H2B::MappedParser& cpuModel = mesh.cpuModel;
+		mesh.indexCount = cpuModel.indexCount;
+		mesh.indexType = cpuModel.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		mesh.packed = cpuModel.IsPacked();
+		if (mesh.packed) {
+			std::memcpy(mesh.boundsCenter, cpuModel.boundsCenter, sizeof(mesh.boundsCenter));
+			std::memcpy(mesh.boundsExtent, cpuModel.boundsExtent, sizeof(mesh.boundsExtent));
+		}
+
+		glGenVertexArrays(1, &mesh.vao);
+		glBindVertexArray(mesh.vao);
+
+		// both sourced straight from the mapped file
+		glGenBuffers(1, &mesh.vertexBufferObject);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferObject);
+		if (mesh.packed)
+			glBufferData(GL_ARRAY_BUFFER, cpuModel.packedVertices.size() * sizeof(H2B::PACKED_VERTEX), cpuModel.packedVertices.data, GL_STATIC_DRAW);
+		else
+			glBufferData(GL_ARRAY_BUFFER, cpuModel.vertices.size() * sizeof(H2B::VERTEX), cpuModel.vertices.data, GL_STATIC_DRAW);
+
+		glGenBuffers(1, &mesh.indexBufferObject);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferObject);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(mesh.indexCount) * cpuModel.indexSize, cpuModel.IndexData(), GL_STATIC_DRAW);
+
+		// Set up vertex attributes, the shader sees the same vec3/vec2/vec3 either way
+		if (mesh.packed) {
+			glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(H2B::PACKED_VERTEX), (void*)offsetof(H2B::PACKED_VERTEX, pos));
+			glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(H2B::PACKED_VERTEX), (void*)offsetof(H2B::PACKED_VERTEX, uv));
+			glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(H2B::PACKED_VERTEX), (void*)offsetof(H2B::PACKED_VERTEX, nrm));
+		}
+		else {
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, pos));
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, uvw));
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, nrm));
+		}
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+
+		glBindVertexArray(0);
+
+		mesh.cpuModel.Clear(); // the GPU has its own copy now
+		return true;
+	}
+public:
+	MeshCache() = default;
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+
+	// Returns the shared mesh for h2bPath, parsing it only the first time. nullptr if it can't be read.
+	// Each successful Acquire needs a matching Release.
+	MESH* Acquire(const std::string& h2bPath) {
+		std::string key = NormalizeAssetPath(h2bPath.c_str());
+		auto found = byPath.find(key);
+		if (found != byPath.end()) {
+			++found->second->references;
+			return found->second;
+		}
+		MESH& mesh = meshes.emplace_back();
+		// the cooked .h2b2 is less than half the size and its vertices are uploaded as they are
+		if (mesh.cpuModel.ParseNewest(h2bPath) == false) {
+			meshes.pop_back();
+			return nullptr;
+		}
+		// the same bytes under another name (a wall exported twice) still share one upload
+		mesh.contentHash = mesh.cpuModel.File().Hash();
+		mesh.contentSize = mesh.cpuModel.File().Size();
+		auto twin = byContent.find(mesh.contentHash);
+		if (twin != byContent.end() && twin->second->contentSize == mesh.contentSize) {
+			MESH* shared = twin->second;
+			meshes.pop_back();
+			shared->paths.push_back(key);
+			byPath.emplace(std::move(key), shared);
+			++shared->references;
+			return shared;
+		}
+		mesh.paths.push_back(key);
+		byPath.emplace(std::move(key), &mesh);
+		byContent.emplace(mesh.contentHash, &mesh);
+		mesh.references = 1;
+		return &mesh;
+	}
+
+	// Drops one reference, the GPU buffers are deleted with the last one
+	void Release(MESH* mesh) {
+		if (mesh == nullptr || --mesh->references > 0)
+			return;
+		glDeleteVertexArrays(1, &mesh->vao);
+		glDeleteBuffers(1, &mesh->vertexBufferObject);
+		glDeleteBuffers(1, &mesh->indexBufferObject);
+		for (const std::string& path : mesh->paths)
+			byPath.erase(path);
+		byContent.erase(mesh->contentHash);
+		for (auto i = meshes.begin(); i != meshes.end(); ++i) {
+			if (&*i == mesh) {
+				meshes.erase(i);
+				break;
+			}
+		}
+	}
+
+	// Sends every mesh acquired since the last call to the GPU
+	void UploadPending() {
+		for (MESH& mesh : meshes) {
+			if (mesh.vao == 0)
+				Upload(mesh);
+		}
+	}
+
+	// unique meshes held and the Models sharing them, for the load log
+	size_t MeshCount() const {
+		return meshes.size();
+	}
+	size_t ReferenceCount() const {
+		size_t total = 0;
+		for (const MESH& mesh : meshes)
+			total += mesh.references;
+		return total;
+	}
+};
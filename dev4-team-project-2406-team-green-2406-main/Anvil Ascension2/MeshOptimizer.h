@@ -0,0 +1,231 @@
+#pragma once
+// Offline index/vertex reordering used by ModelCooker, none of this runs in the game.
+// Triangles are reordered so the GPU's post-transform cache gets more reuse (Forsyth's linear speed algorithm),
+// vertices are renumbered in first use order so fetches walk memory forwards, and cache-cold clusters of
+// triangles can be sorted so outward facing ones draw first to cut overdraw.
+
+#include "h2bParser.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace MeshOptimizer {
+
+	// Average cache misses per triangle for a FIFO cache of cacheSize entries, 3.0 is the worst and ~0.5 the best
+	inline float ACMR(const unsigned* indices, size_t indexCount, unsigned cacheSize = 16) {
+		if (indexCount < 3)
+			return 0;
+		std::vector<unsigned> fifo(cacheSize, ~0u);
+		size_t head = 0, misses = 0;
+		for (size_t i = 0; i < indexCount; ++i) {
+			if (std::find(fifo.begin(), fifo.end(), indices[i]) != fifo.end())
+				continue;
+			fifo[head] = indices[i];
+			head = (head + 1) % cacheSize;
+			++misses;
+		}
+		return static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+	}
+
+	// Reorders the triangles of one index range in place, vertexCount covers every index in the range
+	inline void OptimizeVertexCache(unsigned* indices, size_t indexCount, unsigned vertexCount) {
+		constexpr size_t CACHE_SIZE = 32; // modelled cache, larger than the real one on purpose
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+		struct Vertex {
+			int cachePosition = -1;
+			unsigned remaining = 0; // triangles not yet emitted
+			unsigned firstTriangle = 0; // into triangleLists
+			float score = 0;
+		};
+		std::vector<Vertex> vertices(vertexCount);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			++vertices[indices[i]].remaining;
+		std::vector<unsigned> triangleLists(triangleCount * 3);
+		unsigned offset = 0;
+		for (Vertex& v : vertices) {
+			v.firstTriangle = offset;
+			offset += v.remaining;
+		}
+		std::vector<unsigned> filled(vertexCount, 0);
+		for (size_t t = 0; t < triangleCount; ++t) {
+			for (int k = 0; k < 3; ++k) {
+				unsigned v = indices[t * 3 + k];
+				triangleLists[vertices[v].firstTriangle + filled[v]++] = static_cast<unsigned>(t);
+			}
+		}
+		auto score = [](const Vertex& v) {
+			if (v.remaining == 0)
+				return -1.0f; // nothing left to draw with it
+			float value = 0;
+			if (v.cachePosition >= 0) {
+				if (v.cachePosition < 3)
+					value = 0.75f; // the last triangle's vertices, fixed so strips aren't favoured too much
+				else
+					value = std::pow(1.0f - (v.cachePosition - 3) / static_cast<float>(CACHE_SIZE - 3), 1.5f);
+			}
+			// lonely vertices get a boost so they aren't left to the end
+			return value + 2.0f * std::pow(static_cast<float>(v.remaining), -0.5f);
+		};
+		for (Vertex& v : vertices)
+			v.score = score(v);
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		for (size_t t = 0; t < triangleCount; ++t)
+			triangleScores[t] = vertices[indices[t * 3]].score + vertices[indices[t * 3 + 1]].score +
+				vertices[indices[t * 3 + 2]].score;
+
+		std::vector<unsigned> source(indices, indices + triangleCount * 3);
+		std::vector<unsigned> cache, nextCache;
+		cache.reserve(CACHE_SIZE + 3);
+		nextCache.reserve(CACHE_SIZE + 3);
+		size_t scanStart = 0; // where the fallback search for the best unemitted triangle resumes
+		for (size_t out = 0; out < triangleCount; ++out) {
+			// best triangle touching the cache, or the best overall if the cache has nothing left
+			long best = -1;
+			float bestScore = -1;
+			for (unsigned v : cache) {
+				const Vertex& vertex = vertices[v];
+				for (unsigned i = 0; i < vertex.remaining; ++i) {
+					unsigned t = triangleLists[vertex.firstTriangle + i];
+					if (triangleScores[t] > bestScore) {
+						bestScore = triangleScores[t];
+						best = static_cast<long>(t);
+					}
+				}
+			}
+			if (best < 0) {
+				while (emitted[scanStart])
+					++scanStart;
+				for (size_t t = scanStart; t < triangleCount; ++t) {
+					if (emitted[t] == false && triangleScores[t] > bestScore) {
+						bestScore = triangleScores[t];
+						best = static_cast<long>(t);
+					}
+				}
+			}
+			emitted[best] = true;
+			const unsigned* triangle = &source[best * 3];
+			std::copy(triangle, triangle + 3, indices + out * 3);
+
+			// emitted triangle's vertices go to the front of the cache
+			nextCache.assign(triangle, triangle + 3);
+			for (unsigned v : cache) {
+				if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+					nextCache.push_back(v);
+			}
+			for (int k = 0; k < 3; ++k) {
+				Vertex& vertex = vertices[triangle[k]];
+				unsigned* list = &triangleLists[vertex.firstTriangle];
+				for (unsigned i = 0; i < vertex.remaining; ++i) {
+					if (list[i] == static_cast<unsigned>(best)) {
+						list[i] = list[vertex.remaining - 1];
+						break;
+					}
+				}
+				--vertex.remaining;
+			}
+			for (size_t i = 0; i < nextCache.size(); ++i) {
+				Vertex& vertex = vertices[nextCache[i]];
+				vertex.cachePosition = i < CACHE_SIZE ? static_cast<int>(i) : -1;
+				float oldScore = vertex.score;
+				vertex.score = score(vertex);
+				for (unsigned j = 0; j < vertex.remaining; ++j)
+					triangleScores[triangleLists[vertex.firstTriangle + j]] += vertex.score - oldScore;
+			}
+			if (nextCache.size() > CACHE_SIZE)
+				nextCache.resize(CACHE_SIZE);
+			cache.swap(nextCache);
+		}
+	}
+
+	// Sorts runs of triangles that start on a cold cache so the ones facing away from the middle draw first.
+	// Runs are only split where the cache was going to restart anyway, so ACMR barely moves.
+	// threshold is how much worse (1.05 = 5%) the ACMR may get before the original order is kept.
+	inline void OptimizeOverdraw(unsigned* indices, size_t indexCount, const H2B::VERTEX* vertices,
+		float threshold = 1.05f, unsigned cacheSize = 16) {
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+		// a cluster starts wherever a triangle misses on all three vertices
+		std::vector<size_t> clusterStarts;
+		std::vector<unsigned> fifo(cacheSize, ~0u);
+		size_t head = 0;
+		for (size_t t = 0; t < triangleCount; ++t) {
+			int misses = 0;
+			for (int k = 0; k < 3; ++k) {
+				unsigned v = indices[t * 3 + k];
+				if (std::find(fifo.begin(), fifo.end(), v) != fifo.end())
+					continue;
+				fifo[head] = v;
+				head = (head + 1) % cacheSize;
+				++misses;
+			}
+			if (misses == 3 || t == 0)
+				clusterStarts.push_back(t);
+		}
+		if (clusterStarts.size() < 2)
+			return;
+		clusterStarts.push_back(triangleCount);
+
+		auto position = [vertices](unsigned v) { return &vertices[v].pos.x; };
+		float meshCenter[3] = { 0, 0, 0 };
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			for (int axis = 0; axis < 3; ++axis)
+				meshCenter[axis] += position(indices[i])[axis] / (triangleCount * 3);
+
+		struct Cluster {
+			size_t first, count; // triangles
+			float occlusion; // higher draws first
+		};
+		std::vector<Cluster> clusters;
+		for (size_t i = 0; i + 1 < clusterStarts.size(); ++i) {
+			Cluster cluster = { clusterStarts[i], clusterStarts[i + 1] - clusterStarts[i], 0 };
+			float center[3] = { 0, 0, 0 }, normal[3] = { 0, 0, 0 };
+			for (size_t t = cluster.first; t < cluster.first + cluster.count; ++t) {
+				const float* a = position(indices[t * 3]);
+				const float* b = position(indices[t * 3 + 1]);
+				const float* c = position(indices[t * 3 + 2]);
+				float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				// area weighted face normal
+				normal[0] += ab[1] * ac[2] - ab[2] * ac[1];
+				normal[1] += ab[2] * ac[0] - ab[0] * ac[2];
+				normal[2] += ab[0] * ac[1] - ab[1] * ac[0];
+				for (int axis = 0; axis < 3; ++axis)
+					center[axis] += (a[axis] + b[axis] + c[axis]) / (cluster.count * 3);
+			}
+			float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 0)
+				for (int axis = 0; axis < 3; ++axis)
+					cluster.occlusion += (center[axis] - meshCenter[axis]) * normal[axis] / length;
+			clusters.push_back(cluster);
+		}
+		std::stable_sort(clusters.begin(), clusters.end(),
+			[](const Cluster& a, const Cluster& b) { return a.occlusion > b.occlusion; });
+
+		std::vector<unsigned> sorted;
+		sorted.reserve(triangleCount * 3);
+		for (const Cluster& cluster : clusters)
+			sorted.insert(sorted.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+		if (ACMR(sorted.data(), sorted.size(), cacheSize) <= ACMR(indices, triangleCount * 3, cacheSize) * threshold)
+			std::copy(sorted.begin(), sorted.end(), indices);
+	}
+
+	// Renumbers vertices in the order the indices first use them and reorders the vertex array to match.
+	// Vertices nothing references are dropped off the end.
+	inline void OptimizeVertexFetch(std::vector<H2B::VERTEX>& vertices, std::vector<unsigned>& indices) {
+		std::vector<unsigned> remap(vertices.size(), ~0u);
+		std::vector<H2B::VERTEX> reordered;
+		reordered.reserve(vertices.size());
+		for (unsigned& index : indices) {
+			if (remap[index] == ~0u) {
+				remap[index] = static_cast<unsigned>(reordered.size());
+				reordered.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		vertices.swap(reordered);
+	}
+}
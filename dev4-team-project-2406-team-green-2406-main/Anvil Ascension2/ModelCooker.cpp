@@ -0,0 +1,138 @@
+// Offline tool that cooks .h2b models into the smaller .h2b2 layout the game prefers when it's up to date.
+// usage: ModelCooker [--overdraw] Models/Ball.h2b [Models/Dirt.h2b ...]
+// Each .h2b2 is written next to the .h2b it came from.
+// Triangles and vertices are reordered for the GPU caches on the way, --overdraw also sorts triangle clusters
+// so outward facing ones draw first.
+
+#include "h2bParser.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Packs one model, false if it can't be read or written
+bool CookModel(const char* h2bPath, bool sortForOverdraw) {
+	H2B::MappedParser source;
+	if (source.Parse(h2bPath) == false || source.IsPacked()) {
+		std::cerr << "Not a readable .h2b: " << h2bPath << std::endl;
+		return false;
+	}
+	std::vector<H2B::VERTEX> sourceVertices(source.vertices.begin(), source.vertices.end());
+	std::vector<unsigned> sourceIndices(source.indices.begin(), source.indices.end());
+	float acmrBefore = MeshOptimizer::ACMR(sourceIndices.data(), sourceIndices.size());
+
+	// batches and meshes draw index ranges, triangles are only ever reordered inside one of them
+	std::vector<unsigned> rangeStarts = { 0, source.indexCount };
+	for (const H2B::BATCH& batch : source.batches) {
+		rangeStarts.push_back(batch.indexOffset);
+		rangeStarts.push_back(batch.indexOffset + batch.indexCount);
+	}
+	for (const H2B::MESH_VIEW& mesh : source.meshes) {
+		rangeStarts.push_back(mesh.drawInfo.indexOffset);
+		rangeStarts.push_back(mesh.drawInfo.indexOffset + mesh.drawInfo.indexCount);
+	}
+	std::sort(rangeStarts.begin(), rangeStarts.end());
+	rangeStarts.erase(std::unique(rangeStarts.begin(), rangeStarts.end()), rangeStarts.end());
+	for (size_t i = 0; i + 1 < rangeStarts.size() && rangeStarts[i + 1] <= source.indexCount; ++i) {
+		unsigned* range = sourceIndices.data() + rangeStarts[i];
+		size_t count = rangeStarts[i + 1] - rangeStarts[i];
+		MeshOptimizer::OptimizeVertexCache(range, count, source.vertexCount);
+		if (sortForOverdraw)
+			MeshOptimizer::OptimizeOverdraw(range, count, sourceVertices.data());
+	}
+	float acmrAfter = MeshOptimizer::ACMR(sourceIndices.data(), sourceIndices.size());
+	// every range is done, now the vertices can follow the final index order
+	MeshOptimizer::OptimizeVertexFetch(sourceVertices, sourceIndices);
+	unsigned vertexCount = static_cast<unsigned>(sourceVertices.size());
+
+	// positions are stored relative to the model bounds
+	float center[3], extent[3];
+	H2B::MeasureBounds(sourceVertices.data(), vertexCount, center, extent);
+	std::vector<H2B::PACKED_VERTEX> vertices(vertexCount);
+	float worstError = 0;
+	for (unsigned i = 0; i < vertexCount; ++i) {
+		vertices[i] = H2B::PackVertex(sourceVertices[i], center, extent);
+		H2B::VERTEX check = H2B::UnpackVertex(vertices[i], center, extent);
+		const float* before = &sourceVertices[i].pos.x;
+		const float* after = &check.pos.x;
+		for (int axis = 0; axis < 3; ++axis) {
+			float error = std::fabs(before[axis] - after[axis]);
+			if (error > worstError)
+				worstError = error;
+		}
+	}
+	unsigned indexSize = vertexCount <= 0x10000 ? 2 : 4;
+
+	// materials, batches and meshes are already compact, they're copied over byte for byte
+	MappedFile raw;
+	size_t tail = 20 + 36 * static_cast<size_t>(source.vertexCount) + 4 * static_cast<size_t>(source.indexCount);
+	if (raw.Open(h2bPath) == false || raw.Size() < tail) {
+		std::cerr << "Unable to read: " << h2bPath << std::endl;
+		return false;
+	}
+
+	std::string packedPath = std::string(h2bPath) + "2";
+	std::ofstream file(packedPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (file.is_open() == false) {
+		std::cerr << "Unable to write: " << packedPath << std::endl;
+		return false;
+	}
+	file.write(H2B::PACKED_MAGIC, 4);
+	file.write(reinterpret_cast<const char*>(&vertexCount), 4);
+	file.write(reinterpret_cast<const char*>(&source.indexCount), 4);
+	file.write(reinterpret_cast<const char*>(&source.materialCount), 4);
+	file.write(reinterpret_cast<const char*>(&source.meshCount), 4);
+	file.write(reinterpret_cast<const char*>(&indexSize), 4);
+	file.write(reinterpret_cast<const char*>(center), 12);
+	file.write(reinterpret_cast<const char*>(extent), 12);
+	file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(H2B::PACKED_VERTEX));
+	if (indexSize == 2) {
+		std::vector<unsigned short> indices(sourceIndices.begin(), sourceIndices.end());
+		if (indices.size() & 1)
+			indices.push_back(0); // keeps the materials that follow 4 byte aligned
+		file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * 2);
+	}
+	else
+		file.write(reinterpret_cast<const char*>(sourceIndices.data()), sourceIndices.size() * 4);
+	file.write(reinterpret_cast<const char*>(raw.Data() + tail), raw.Size() - tail);
+	if (file.good() == false) {
+		std::cerr << "Unable to write: " << packedPath << std::endl;
+		return false;
+	}
+	size_t packedSize = static_cast<size_t>(file.tellp());
+	file.close();
+
+	// MeshCache and Level_Data load it through MappedParser, so it has to parse back to the same counts
+	H2B::MappedParser check;
+	if (check.Parse(packedPath.c_str()) == false || check.vertexCount != vertexCount ||
+		check.indexCount != source.indexCount || check.meshCount != source.meshCount) {
+		std::cerr << "Cooked model failed validation: " << packedPath << std::endl;
+		return false;
+	}
+	std::cout << "Cooked " << h2bPath << " -> " << packedPath << " (" << vertexCount << " vertices, "
+		<< indexSize * 8 << " bit indices, " << raw.Size() << " -> " << packedSize << " bytes, "
+		<< "max position error " << worstError << ")" << std::endl;
+	std::cout << "    ACMR " << acmrBefore << " -> " << acmrAfter << " (16 entry FIFO)" << std::endl;
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	bool sortForOverdraw = false;
+	int first = 1;
+	if (argc > 1 && std::string(argv[1]) == "--overdraw") {
+		sortForOverdraw = true;
+		first = 2;
+	}
+	if (argc <= first) {
+		std::cerr << "usage: ModelCooker [--overdraw] Model.h2b [Model2.h2b ...]" << std::endl;
+		return 1;
+	}
+	int failures = 0;
+	for (int i = first; i < argc; ++i) {
+		if (CookModel(argv[i], sortForOverdraw) == false)
+			++failures;
+	}
+	return failures == 0 ? 0 : 1;
+}
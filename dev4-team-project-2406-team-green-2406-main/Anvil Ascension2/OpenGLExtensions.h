@@ -1,6 +1,8 @@
 #ifndef OGL_EXTENSIONS_H
 #define OGL_EXTENSIONS_H
 
+#include <cstring>
+
 // Modern OpenGL API Functions must be queried before use
 PFNGLCREATESHADERPROC				glCreateShader = nullptr;
 PFNGLSHADERSOURCEPROC				glShaderSource = nullptr;
@@ -37,8 +39,38 @@ PFNGLACTIVETEXTUREPROC glActiveTexture = nullptr;
 PFNGLGENERATEMIPMAPPROC glGenerateMipmap = nullptr;
 PFNGLUNIFORM1IPROC glUniform1i = nullptr;
 PFNGLUNIFORM3FVPROC glUniform3fv = nullptr;
+PFNGLUNIFORM4FVPROC glUniform4fv = nullptr;
 PFNGLUNIFORM1FPROC glUniform1f = nullptr;
 PFNGLUNIFORM3FPROC glUniform3f = nullptr;
+PFNGLMAPBUFFERRANGEPROC glMapBufferRange = nullptr;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer = nullptr;
+PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D = nullptr;
+PFNGLTEXIMAGE3DPROC glTexImage3D = nullptr;
+PFNGLTEXSUBIMAGE3DPROC glTexSubImage3D = nullptr;
+PFNGLCOMPRESSEDTEXIMAGE3DPROC glCompressedTexImage3D = nullptr;
+PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC glCompressedTexSubImage3D = nullptr;
+PFNGLGETACTIVEUNIFORMPROC glGetActiveUniform = nullptr;
+PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC glGetActiveUniformBlockName = nullptr;
+PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor = nullptr;
+PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC glDrawElementsInstancedBaseVertex = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect = nullptr; // GL 4.3, stays nullptr on older drivers
+PFNGLBUFFERSTORAGEPROC glBufferStorage = nullptr; // GL 4.4, stays nullptr on older drivers
+PFNGLBINDBUFFERRANGEPROC glBindBufferRange = nullptr;
+PFNGLFENCESYNCPROC glFenceSync = nullptr;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync = nullptr;
+PFNGLDELETESYNCPROC glDeleteSync = nullptr;
+PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers = nullptr;
+PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer = nullptr;
+PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers = nullptr;
+PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers = nullptr;
+PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer = nullptr;
+PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers = nullptr;
+PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage = nullptr;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer = nullptr;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus = nullptr;
+PFNGLBLITFRAMEBUFFERPROC glBlitFramebuffer = nullptr;
+PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC glGetFramebufferAttachmentParameteriv = nullptr;
+PFNGLGETSTRINGIPROC glGetStringi = nullptr;
 
 void QueryOGLExtensionFunctions(GW::GRAPHICS::GOpenGLSurface ogl)
 {
@@ -78,8 +110,70 @@ void QueryOGLExtensionFunctions(GW::GRAPHICS::GOpenGLSurface ogl)
 	ogl.QueryExtensionFunction(nullptr, "glGenerateMipmap", (void**)&glGenerateMipmap);
 	ogl.QueryExtensionFunction(nullptr, "glUniform1i", (void**)&glUniform1i);
 	ogl.QueryExtensionFunction(nullptr, "glUniform3fv", (void**)&glUniform3fv);
+	ogl.QueryExtensionFunction(nullptr, "glUniform4fv", (void**)&glUniform4fv);
 	ogl.QueryExtensionFunction(nullptr, "glUniform1f", (void**)&glUniform1f);
+	ogl.QueryExtensionFunction(nullptr, "glMapBufferRange", (void**)&glMapBufferRange);
+	ogl.QueryExtensionFunction(nullptr, "glUnmapBuffer", (void**)&glUnmapBuffer);
+	ogl.QueryExtensionFunction(nullptr, "glCompressedTexImage2D", (void**)&glCompressedTexImage2D);
+	ogl.QueryExtensionFunction(nullptr, "glTexImage3D", (void**)&glTexImage3D);
+	ogl.QueryExtensionFunction(nullptr, "glTexSubImage3D", (void**)&glTexSubImage3D);
+	ogl.QueryExtensionFunction(nullptr, "glCompressedTexImage3D", (void**)&glCompressedTexImage3D);
+	ogl.QueryExtensionFunction(nullptr, "glCompressedTexSubImage3D", (void**)&glCompressedTexSubImage3D);
+	ogl.QueryExtensionFunction(nullptr, "glGetActiveUniform", (void**)&glGetActiveUniform);
+	ogl.QueryExtensionFunction(nullptr, "glGetActiveUniformBlockName", (void**)&glGetActiveUniformBlockName);
+	ogl.QueryExtensionFunction(nullptr, "glVertexAttribDivisor", (void**)&glVertexAttribDivisor);
+	ogl.QueryExtensionFunction(nullptr, "glDrawElementsInstancedBaseVertex", (void**)&glDrawElementsInstancedBaseVertex);
+	ogl.QueryExtensionFunction(nullptr, "glMultiDrawElementsIndirect", (void**)&glMultiDrawElementsIndirect);
+	ogl.QueryExtensionFunction(nullptr, "glBufferStorage", (void**)&glBufferStorage);
+	ogl.QueryExtensionFunction(nullptr, "glBindBufferRange", (void**)&glBindBufferRange);
+	ogl.QueryExtensionFunction(nullptr, "glFenceSync", (void**)&glFenceSync);
+	ogl.QueryExtensionFunction(nullptr, "glClientWaitSync", (void**)&glClientWaitSync);
+	ogl.QueryExtensionFunction(nullptr, "glDeleteSync", (void**)&glDeleteSync);
+	ogl.QueryExtensionFunction(nullptr, "glGenFramebuffers", (void**)&glGenFramebuffers);
+	ogl.QueryExtensionFunction(nullptr, "glBindFramebuffer", (void**)&glBindFramebuffer);
+	ogl.QueryExtensionFunction(nullptr, "glDeleteFramebuffers", (void**)&glDeleteFramebuffers);
+	ogl.QueryExtensionFunction(nullptr, "glGenRenderbuffers", (void**)&glGenRenderbuffers);
+	ogl.QueryExtensionFunction(nullptr, "glBindRenderbuffer", (void**)&glBindRenderbuffer);
+	ogl.QueryExtensionFunction(nullptr, "glDeleteRenderbuffers", (void**)&glDeleteRenderbuffers);
+	ogl.QueryExtensionFunction(nullptr, "glRenderbufferStorage", (void**)&glRenderbufferStorage);
+	ogl.QueryExtensionFunction(nullptr, "glFramebufferRenderbuffer", (void**)&glFramebufferRenderbuffer);
+	ogl.QueryExtensionFunction(nullptr, "glCheckFramebufferStatus", (void**)&glCheckFramebufferStatus);
+	ogl.QueryExtensionFunction(nullptr, "glBlitFramebuffer", (void**)&glBlitFramebuffer);
+	ogl.QueryExtensionFunction(nullptr, "glGetFramebufferAttachmentParameteriv", (void**)&glGetFramebufferAttachmentParameteriv);
+	ogl.QueryExtensionFunction(nullptr, "glGetStringi", (void**)&glGetStringi);
 	
 }
 
+// True when the current context lists extension. A function pointer being found doesn't say the driver
+// supports what it's for, so features that come from an extension are checked here instead.
+bool HasOGLExtension(const char* extension)
+{
+	if (glGetStringi == nullptr) {
+		// pre 3.0 contexts only have the one space separated string
+		const char* all = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+		size_t length = std::strlen(extension);
+		for (const char* found = all; found != nullptr && (found = std::strstr(found, extension)) != nullptr; found += length) {
+			if ((found == all || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+				return true;
+		}
+		return false;
+	}
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+		if (name != nullptr && std::strcmp(name, extension) == 0)
+			return true;
+	}
+	return false;
+}
+// True when the current context is at least major.minor
+bool HasOGLVersion(int major, int minor)
+{
+	GLint contextMajor = 0, contextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
 #endif
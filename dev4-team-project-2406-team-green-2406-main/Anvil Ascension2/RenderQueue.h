@@ -0,0 +1,112 @@
+#pragma once
+// Draw items collected each frame and sorted by a packed 64 bit key before anything is submitted.
+// From the top bit down the key is pass, program, texture, mesh and then depth, so items sharing state end up
+// next to each other and within a state run they go front to back.
+// Submit hands each item over with the parts of its key that differ from the item before it, state whose
+// bits didn't change is left bound and counted as avoided.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class RenderQueue {
+public:
+	static constexpr unsigned PASS_BITS = 4, PROGRAM_BITS = 8, TEXTURE_BITS = 16, MESH_BITS = 16, DEPTH_BITS = 20;
+	static constexpr unsigned DEPTH_SHIFT = 0;
+	static constexpr unsigned MESH_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+	static constexpr unsigned TEXTURE_SHIFT = MESH_SHIFT + MESH_BITS;
+	static constexpr unsigned PROGRAM_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+	static constexpr unsigned PASS_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+	// what Submit reports changed, a new pass or program changes everything below it too
+	enum CHANGE : unsigned {
+		PROGRAM_CHANGED = 1,
+		TEXTURE_CHANGED = 2,
+		MESH_CHANGED = 4,
+	};
+	struct ITEM {
+		uint64_t key;
+		unsigned index; // whatever the caller uses to find what to draw
+	};
+private:
+	std::vector<ITEM> items, scratch;
+	// last Submit, state changes made and the ones skipped because the bits matched
+	size_t changes = 0, avoided = 0;
+
+	static uint64_t Field(unsigned value, unsigned bits, unsigned shift) {
+		return (static_cast<uint64_t>(value) & ((uint64_t(1) << bits) - 1)) << shift;
+	}
+	static uint64_t Bits(uint64_t key, unsigned bits, unsigned shift) {
+		return (key >> shift) & ((uint64_t(1) << bits) - 1);
+	}
+public:
+	// Packs a key. Values wider than their field are cut down, callers hand out dense ids so they never are.
+	// depth is 0 at the near plane to 1 at the far one.
+	static uint64_t MakeKey(unsigned pass, unsigned program, unsigned texture, unsigned mesh, float depth) {
+		depth = depth < 0.0f ? 0.0f : depth > 1.0f ? 1.0f : depth;
+		unsigned quantized = static_cast<unsigned>(depth * static_cast<float>((1u << DEPTH_BITS) - 1));
+		return Field(pass, PASS_BITS, PASS_SHIFT) | Field(program, PROGRAM_BITS, PROGRAM_SHIFT) |
+			Field(texture, TEXTURE_BITS, TEXTURE_SHIFT) | Field(mesh, MESH_BITS, MESH_SHIFT) | Field(quantized, DEPTH_BITS, DEPTH_SHIFT);
+	}
+
+	void Clear() {
+		items.clear();
+	}
+	void Push(uint64_t key, unsigned index) {
+		items.push_back({ key, index });
+	}
+
+	// LSD radix sort a byte at a time, stable, and bytes every key shares are skipped
+	void Sort() {
+		scratch.resize(items.size());
+		for (unsigned shift = 0; shift < 64; shift += 8) {
+			size_t counts[256] = {};
+			for (const ITEM& item : items)
+				++counts[(item.key >> shift) & 0xFF];
+			if (items.empty() || counts[(items[0].key >> shift) & 0xFF] == items.size())
+				continue;
+			size_t offset = 0;
+			for (size_t& count : counts) {
+				size_t next = offset + count;
+				count = offset;
+				offset = next;
+			}
+			for (const ITEM& item : items)
+				scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+			items.swap(scratch);
+		}
+	}
+
+	// Calls draw(index, changed) for every item in key order, changed is a mask of CHANGE bits
+	template <typename DRAW>
+	void Submit(DRAW&& draw) {
+		changes = 0;
+		avoided = 0;
+		uint64_t previous = 0;
+		for (size_t i = 0; i < items.size(); ++i) {
+			uint64_t key = items[i].key;
+			unsigned changed = PROGRAM_CHANGED | TEXTURE_CHANGED | MESH_CHANGED;
+			if (i > 0 && Bits(key, PASS_BITS + PROGRAM_BITS, PROGRAM_SHIFT) == Bits(previous, PASS_BITS + PROGRAM_BITS, PROGRAM_SHIFT)) {
+				changed &= ~PROGRAM_CHANGED;
+				if (Bits(key, TEXTURE_BITS, TEXTURE_SHIFT) == Bits(previous, TEXTURE_BITS, TEXTURE_SHIFT))
+					changed &= ~TEXTURE_CHANGED;
+				if (Bits(key, MESH_BITS, MESH_SHIFT) == Bits(previous, MESH_BITS, MESH_SHIFT))
+					changed &= ~MESH_CHANGED;
+			}
+			for (unsigned bit = PROGRAM_CHANGED; bit <= MESH_CHANGED; bit <<= 1)
+				(changed & bit) ? ++changes : ++avoided;
+			draw(items[i].index, changed);
+			previous = key;
+		}
+	}
+
+	size_t ItemCount() const {
+		return items.size();
+	}
+	// program, texture and mesh binds the last Submit made, and the ones it skipped
+	size_t StateChangeCount() const {
+		return changes;
+	}
+	size_t StateChangesAvoided() const {
+		return avoided;
+	}
+};
@@ -0,0 +1,142 @@
+#pragma once
+// A GL buffer split into FRAMES sections that are written in turn, one per frame.
+// The CPU writes straight into mapped memory instead of calling glBufferSubData, and a fence on each section
+// means it only waits if the GPU is still reading what was written FRAMES frames ago.
+// With glBufferStorage (GL 4.4 or GL_ARB_buffer_storage) the buffer stays mapped for its whole life, otherwise
+// each section is mapped unsynchronized for the frame and must be unmapped with Flush before anything draws from it.
+
+#include <cstring>
+
+class RingBuffer {
+public:
+	static constexpr unsigned FRAMES = 3;
+private:
+	GLenum target = GL_ARRAY_BUFFER;
+	GLuint buffer = 0;
+	size_t sectionSize = 0;
+	size_t alignment = 1;
+	bool persistent = false;
+	unsigned char* mapped = nullptr; // whole buffer when persistent, this frame's section otherwise
+	GLsync fences[FRAMES] = {};
+	unsigned section = 0;
+	size_t used = 0; // bytes handed out from this frame's section
+	size_t frameBytes = 0, lastFrameBytes = 0;
+
+	void Destroy() {
+		for (GLsync& fence : fences) {
+			if (fence != nullptr) {
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		if (buffer != 0) {
+			glBindBuffer(target, buffer);
+			if (mapped != nullptr)
+				glUnmapBuffer(target);
+			glBindBuffer(target, 0);
+			glDeleteBuffers(1, &buffer);
+		}
+		buffer = 0;
+		mapped = nullptr;
+	}
+public:
+	RingBuffer() = default;
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+	~RingBuffer() {
+		Destroy();
+	}
+
+	// Makes sure each frame can hold bytesPerFrame, reallocating (after the GPU is done with it) if it can't.
+	// Offsets Allocate hands out are multiples of offsetAlignment, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for UBOs.
+	void Reserve(GLenum bufferTarget, size_t bytesPerFrame, size_t offsetAlignment) {
+		offsetAlignment = offsetAlignment > 0 ? offsetAlignment : 1;
+		size_t needed = (bytesPerFrame + offsetAlignment - 1) / offsetAlignment * offsetAlignment;
+		if (buffer != 0 && target == bufferTarget && needed <= sectionSize && offsetAlignment == alignment)
+			return;
+		Destroy();
+		target = bufferTarget;
+		alignment = offsetAlignment;
+		sectionSize = needed > 0 ? needed : alignment;
+		section = 0;
+		used = 0;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(target, buffer);
+		GLsizeiptr total = static_cast<GLsizeiptr>(sectionSize * FRAMES);
+		// the entry point can load on drivers that don't support it, so the version says whether it's there
+		persistent = glBufferStorage != nullptr && (HasOGLVersion(4, 4) || HasOGLExtension("GL_ARB_buffer_storage"));
+		if (persistent) {
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(target, total, nullptr, flags);
+			mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, total, flags));
+			persistent = mapped != nullptr;
+		}
+		if (persistent == false)
+			glBufferData(target, total, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(target, 0);
+	}
+
+	// Moves on to the next section, waiting only if the GPU hasn't finished the frame that last used it
+	void BeginFrame() {
+		section = (section + 1) % FRAMES;
+		used = 0;
+		frameBytes = 0;
+		if (fences[section] != nullptr) {
+			glClientWaitSync(fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fences[section]);
+			fences[section] = nullptr;
+		}
+		if (persistent == false && buffer != 0) {
+			glBindBuffer(target, buffer);
+			// the fence already kept us off anything in flight, so the driver doesn't need to sync either
+			mapped = static_cast<unsigned char*>(glMapBufferRange(target, static_cast<GLintptr>(sectionSize * section),
+				static_cast<GLsizeiptr>(sectionSize), GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+			glBindBuffer(target, 0);
+		}
+	}
+
+	// Room for bytes in this frame's section, nullptr when it's full. offset is where it sits in Id().
+	void* Allocate(size_t bytes, GLintptr& offset) {
+		if (mapped == nullptr || used + bytes > sectionSize)
+			return nullptr;
+		offset = static_cast<GLintptr>(sectionSize * section + used);
+		unsigned char* out = persistent ? mapped + offset : mapped + used;
+		used += (bytes + alignment - 1) / alignment * alignment;
+		frameBytes += bytes;
+		return out;
+	}
+	// Allocate and copy in one go, false when the section is full
+	bool Write(const void* data, size_t bytes, GLintptr& offset) {
+		void* out = Allocate(bytes, offset);
+		if (out == nullptr)
+			return false;
+		std::memcpy(out, data, bytes);
+		return true;
+	}
+
+	// Call once the frame's writes are done and before drawing from them
+	void Flush() {
+		if (persistent == false && mapped != nullptr) {
+			glBindBuffer(target, buffer);
+			glUnmapBuffer(target);
+			glBindBuffer(target, 0);
+			mapped = nullptr;
+		}
+	}
+	// Call after the frame's draws are submitted, the section is reused once the GPU passes this point
+	void EndFrame() {
+		Flush();
+		lastFrameBytes = frameBytes;
+		if (buffer != 0)
+			fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	GLuint Id() const {
+		return buffer;
+	}
+	// bytes written into the ring between the last BeginFrame and EndFrame
+	size_t LastFrameBytes() const {
+		return lastFrameBytes;
+	}
+};
@@ -0,0 +1,189 @@
+#pragma once
+// A linked GLSL program that knows its own uniforms.
+// Every active uniform and uniform block is looked up once after linking, drawing code holds on to the
+// slot Uniform returns instead of calling glGetUniformLocation every frame.
+// The setters remember what each uniform was last given and skip the glUniform call when it hasn't changed.
+
+#include "FileIntoString.h"
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ShaderProgram {
+	struct UNIFORM {
+		GLint location = -1;
+		GLenum type = 0;
+		bool set = false; // value below holds what the GPU has
+		unsigned char value[16] = {}; // up to a vec4, compared bytewise
+	};
+	GLuint program = 0;
+	std::vector<UNIFORM> uniforms;
+	std::unordered_map<std::string, int> uniformSlots;
+	std::unordered_map<std::string, GLuint> blocks;
+	std::string errors;
+	size_t uploads = 0, skipped = 0;
+
+	// returns the shader or 0 with errors filled in
+	GLuint CompileStage(GLenum stage, const char* sourcePath, const char* label) {
+		std::string source = ReadFileIntoString(sourcePath);
+		const GLchar* strings[1] = { source.c_str() };
+		const GLint lengths[1] = { static_cast<GLint>(source.length()) };
+		GLuint shader = glCreateShader(stage);
+		glShaderSource(shader, 1, strings, lengths);
+		glCompileShader(shader);
+		GLint result;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
+		if (result == false) {
+			char log[1024];
+			glGetShaderInfoLog(shader, 1024, NULL, log);
+			errors = std::string(label) + log;
+			glDeleteShader(shader);
+			return 0;
+		}
+		return shader;
+	}
+	void Reflect() {
+		GLint count = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			char name[256];
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(program, i, sizeof(name), &length, &size, &type, name);
+			GLint location = glGetUniformLocation(program, name);
+			if (location == -1)
+				continue; // lives in a uniform block
+			std::string key(name, length);
+			if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+				key.erase(key.size() - 3); // arrays report their first element
+			UNIFORM& uniform = uniforms.emplace_back();
+			uniform.location = location;
+			uniform.type = type;
+			uniformSlots.emplace(std::move(key), static_cast<int>(uniforms.size() - 1));
+		}
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			char name[256];
+			GLsizei length = 0;
+			glGetActiveUniformBlockName(program, i, sizeof(name), &length, name);
+			blocks.emplace(std::string(name, length), static_cast<GLuint>(i));
+		}
+	}
+	// true if the GPU needs the value, which is then remembered
+	bool Changed(int slot, const void* value, size_t bytes) {
+		UNIFORM& uniform = uniforms[slot];
+		if (uniform.set && std::memcmp(uniform.value, value, bytes) == 0) {
+			++skipped;
+			return false;
+		}
+		std::memcpy(uniform.value, value, bytes);
+		uniform.set = true;
+		++uploads;
+		return true;
+	}
+public:
+	ShaderProgram() = default;
+	ShaderProgram(const ShaderProgram&) = delete;
+	ShaderProgram& operator=(const ShaderProgram&) = delete;
+	~ShaderProgram() {
+		if (program != 0)
+			glDeleteProgram(program);
+	}
+
+	// Compiles and links both stages and reflects the result, false with Errors() filled in if either fails
+	bool Create(const char* vertexPath, const char* fragmentPath) {
+		errors.clear();
+		GLuint vertexShader = CompileStage(GL_VERTEX_SHADER, vertexPath, "Vertex Shader Errors:\n");
+		if (vertexShader == 0)
+			return false;
+		GLuint fragmentShader = CompileStage(GL_FRAGMENT_SHADER, fragmentPath, "Fragment Shader Errors:\n");
+		if (fragmentShader == 0) {
+			glDeleteShader(vertexShader);
+			return false;
+		}
+		GLuint linked = glCreateProgram();
+		glAttachShader(linked, vertexShader);
+		glAttachShader(linked, fragmentShader);
+		glLinkProgram(linked);
+		// no longer needed once linked
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		GLint result;
+		glGetProgramiv(linked, GL_LINK_STATUS, &result);
+		if (result == false) {
+			char log[1024];
+			glGetProgramInfoLog(linked, 1024, NULL, log);
+			errors = std::string("Shader Program Linking Errors:\n") + log;
+			glDeleteProgram(linked);
+			return false;
+		}
+		if (program != 0)
+			glDeleteProgram(program);
+		program = linked;
+		uniforms.clear();
+		uniformSlots.clear();
+		blocks.clear();
+		Reflect();
+		return true;
+	}
+	const std::string& Errors() const {
+		return errors;
+	}
+
+	GLuint Id() const {
+		return program;
+	}
+	void Use() const {
+		glUseProgram(program);
+	}
+
+	// Slot for a uniform the shader actually uses, -1 otherwise. Setting -1 does nothing, like location -1.
+	int Uniform(const char* name) const {
+		auto found = uniformSlots.find(name);
+		return found == uniformSlots.end() ? -1 : found->second;
+	}
+	// index of a uniform block, GL_INVALID_INDEX if the shader doesn't have it
+	GLuint Block(const char* name) const {
+		auto found = blocks.find(name);
+		return found == blocks.end() ? GL_INVALID_INDEX : found->second;
+	}
+	// ties a block to a GL_UNIFORM_BUFFER binding point, false if the shader doesn't have it
+	bool BindBlock(const char* name, GLuint binding) const {
+		GLuint index = Block(name);
+		if (index == GL_INVALID_INDEX)
+			return false;
+		glUniformBlockBinding(program, index, binding);
+		return true;
+	}
+
+	// The setters write to this program, it must be the one in use
+	void Set(int slot, GLint value) {
+		if (slot >= 0 && Changed(slot, &value, sizeof(value)))
+			glUniform1i(uniforms[slot].location, value);
+	}
+	void Set(int slot, float value) {
+		if (slot >= 0 && Changed(slot, &value, sizeof(value)))
+			glUniform1f(uniforms[slot].location, value);
+	}
+	// as many components as the shader declared, all four for a vec4 and xyz for a vec3
+	void Set(int slot, const GW::MATH::GVECTORF& value) {
+		if (slot < 0)
+			return;
+		if (uniforms[slot].type == GL_FLOAT_VEC4) {
+			if (Changed(slot, &value, sizeof(float) * 4))
+				glUniform4fv(uniforms[slot].location, 1, &value.x);
+		}
+		else if (Changed(slot, &value, sizeof(float) * 3))
+			glUniform3fv(uniforms[slot].location, 1, &value.x);
+	}
+
+	// glUniform calls made and the ones skipped because the value was already there
+	size_t UploadCount() const {
+		return uploads;
+	}
+	size_t SkippedCount() const {
+		return skipped;
+	}
+};
@@ -0,0 +1,42 @@
+#version 330 core
+
+// Lights and textures the level for both VertexShader.glsl and InstancedVertexShader.glsl.
+// The texture is layer textureLayer of texture_layers once TextureCache has packed it into an array,
+// until then (or with arrays off) textureLayer is -1 and texture_diffuse holds it.
+
+in vec3 fragPos;
+in vec3 worldNorm;
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D texture_diffuse;
+uniform sampler2DArray texture_layers;
+uniform int textureLayer;
+uniform vec3 ambientColor;
+uniform vec3 lightDir;    // Light direction
+uniform vec3 lightColor;  // Light color
+uniform vec3 mapCenter;
+
+void main()
+{
+    // Normalize the normal vector
+    vec3 norm = normalize(worldNorm);
+
+    // Calculate the diffuse lighting
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    // Sample color from the array layer or the plain texture
+    vec3 textureColor = textureLayer >= 0 ?
+        texture(texture_layers, vec3(TexCoords, float(textureLayer))).rgb : texture(texture_diffuse, TexCoords).rgb;
+
+    // Calculate the ambient and diffuse components
+    vec3 ambient = textureColor * ambientColor;
+    vec3 diffuse = diff * textureColor * lightColor;
+
+    // Combine ambient and diffuse components
+    vec3 color = ambient + diffuse;
+
+    // Output the final color
+    FragColor = vec4(color, 1.0);
+}
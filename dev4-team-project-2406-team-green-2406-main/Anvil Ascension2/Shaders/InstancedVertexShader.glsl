@@ -0,0 +1,44 @@
+#version 330 core
+
+// Same as VertexShader.glsl except the world and normal matrices come from the instance buffer, one per instance drawn.
+// Links with FragmentShader.glsl, the outputs below are the ones it reads.
+
+layout (std140) uniform UboData {
+    vec4 sunDirection;
+    vec4 sunColor;
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+};
+
+// Input from VBO
+layout(location = 0) in vec3 localPos;
+layout(location = 1) in vec2 localTexCoords;
+layout(location = 2) in vec3 localNorm;
+// Input from the instance buffer, the world matrix takes locations 3 to 6 and its normal matrix 7 to 9
+layout(location = 3) in mat4 instanceWorld;
+layout(location = 7) in mat3 instanceNormal;
+
+// Output to Fragment shader
+out vec3 worldNorm;
+out vec3 fragPos;
+out vec2 TexCoords;
+
+void main()
+{
+    // Transform position to world space
+    vec4 worldPosition = instanceWorld * vec4(localPos, 1.0);
+
+    // Transform normal to world space, the inverse transpose was made on the CPU once per instance
+    worldNorm = instanceNormal * localNorm;
+
+    fragPos = worldPosition.xyz;
+
+    // Pass through the texture coordinates
+    TexCoords = localTexCoords;
+
+    // Transform position to view space
+    vec4 viewPosition = viewMatrix * worldPosition;
+
+    // Transform position to clip space
+    gl_Position = projectionMatrix * viewPosition;
+}
@@ -0,0 +1,129 @@
+#pragma once
+// An offscreen color and depth target the parts of the level that never move are drawn into once.
+// Every frame Present blits both into the window, so moving objects drawn afterwards are still hidden behind
+// walls and props by the depth test without any of those being drawn again.
+// It's redrawn only after Invalidate, which the owner calls whenever what the layer shows could have changed.
+
+#include <iostream>
+
+class StaticLayer {
+	GLuint framebuffer = 0, color = 0, depth = 0;
+	unsigned width = 0, height = 0;
+	bool valid = false;
+	bool disabled = false; // the window's framebuffer can't take a blit from this one
+	bool checked = false; // first Present looks for the blit being refused
+	size_t bakes = 0;
+
+	void Destroy() {
+		if (framebuffer != 0) {
+			glDeleteFramebuffers(1, &framebuffer);
+			glDeleteRenderbuffers(1, &color);
+			glDeleteRenderbuffers(1, &depth);
+		}
+		framebuffer = color = depth = 0;
+		valid = false;
+	}
+	// Depth can only be blitted between matching formats, so match whatever the window was given
+	static GLenum WindowDepthFormat() {
+		GLint depthBits = 0, stencilBits = 0;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+		glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_STENCIL, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+		if (stencilBits > 0)
+			return GL_DEPTH24_STENCIL8;
+		if (depthBits >= 32)
+			return GL_DEPTH_COMPONENT32F;
+		return depthBits > 16 ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT16;
+	}
+public:
+	StaticLayer() = default;
+	StaticLayer(const StaticLayer&) = delete;
+	StaticLayer& operator=(const StaticLayer&) = delete;
+	~StaticLayer() {
+		Destroy();
+	}
+
+	// Matches the layer to the window size, recreating and invalidating it when that changed.
+	// false when there's no usable layer, everything has to be drawn every frame then.
+	bool Resize(unsigned windowWidth, unsigned windowHeight) {
+		if (disabled || glBlitFramebuffer == nullptr || windowWidth == 0 || windowHeight == 0)
+			return false;
+		if (framebuffer != 0 && windowWidth == width && windowHeight == height)
+			return true;
+		Destroy();
+		// a multisampled window can't be blitted into from a single sampled layer
+		GLint samples = 0;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glGetIntegerv(GL_SAMPLES, &samples);
+		if (samples > 0) {
+			disabled = true;
+			return false;
+		}
+		GLenum depthFormat = WindowDepthFormat();
+		width = windowWidth;
+		height = windowHeight;
+		glGenFramebuffers(1, &framebuffer);
+		glGenRenderbuffers(1, &color);
+		glGenRenderbuffers(1, &depth);
+		glBindRenderbuffer(GL_RENDERBUFFER, color);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, depth);
+		glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, depthFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+			GL_RENDERBUFFER, depth);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			std::cerr << "Static layer framebuffer incomplete, drawing the whole level every frame." << std::endl;
+			Destroy();
+			disabled = true;
+			return false;
+		}
+		return true;
+	}
+	void Invalidate() {
+		valid = false;
+	}
+	bool IsValid() const {
+		return valid;
+	}
+
+	// Everything drawn between BeginBake and EndBake goes into the layer instead of the window
+	void BeginBake() {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+	void EndBake() {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		valid = true;
+		++bakes;
+	}
+
+	// Copies the layer's color and depth into the window, false if the GL refused and the layer is now off
+	bool Present() {
+		if (checked == false)
+			while (glGetError() != GL_NO_ERROR) {} // only the blit's own error counts below
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (checked == false) {
+			checked = true;
+			if (glGetError() != GL_NO_ERROR) {
+				std::cerr << "Static layer could not be blitted to the window, drawing the whole level every frame." << std::endl;
+				Destroy();
+				disabled = true;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// times the static level has been drawn into the layer
+	size_t BakeCount() const {
+		return bakes;
+	}
+};
@@ -0,0 +1,25 @@
+#pragma once
+// Bare bones checks for the small behaviour tests in this folder.
+// CHECK prints the failing expression and keeps going so one run shows every failure, main returns Failures().
+
+#include <iostream>
+
+inline int& FailureCount() {
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+			++FailureCount(); \
+		} \
+	} while (false)
+
+// what main returns, 0 when every CHECK passed
+inline int Failures() {
+	if (FailureCount() > 0)
+		std::cerr << FailureCount() << " checks failed" << std::endl;
+	return FailureCount() > 0 ? 1 : 0;
+}
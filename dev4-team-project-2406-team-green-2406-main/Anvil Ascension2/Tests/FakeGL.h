@@ -0,0 +1,136 @@
+#pragma once
+// Just enough of the GL for the buffer helpers to run without a context.
+// Buffers are plain byte vectors, mapping hands out pointers into them and fences only count what was
+// asked of them, so a test can check where data landed and when the CPU would have waited.
+// Include it ahead of the header under test, the way main.cpp includes OpenGLExtensions.h.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned int GLbitfield;
+typedef unsigned char GLboolean;
+typedef std::ptrdiff_t GLintptr;
+typedef std::ptrdiff_t GLsizeiptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_STREAM_DRAW 0x88E0
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#define GL_ALREADY_SIGNALED 0x911A
+
+// what the fake context reports and everything done to it
+struct FAKE_GL {
+	struct BUFFER {
+		std::vector<unsigned char> bytes;
+		bool immutable = false; // made by glBufferStorage
+		bool mapped = false;
+		GLbitfield mapFlags = 0;
+	};
+	int major = 4, minor = 6;
+	std::vector<std::string> extensions;
+	std::map<GLuint, BUFFER> buffers;
+	std::map<GLenum, GLuint> bound;
+	GLuint nextId = 1;
+	unsigned maps = 0, unmaps = 0;
+	uintptr_t nextFence = 1;
+	std::vector<uintptr_t> waitedOn, deleted; // fences in the order they were waited on and deleted
+	uintptr_t lastFence = 0;
+
+	BUFFER& Bound(GLenum target) {
+		return buffers[bound[target]];
+	}
+};
+inline FAKE_GL& FakeGL() {
+	static FAKE_GL gl;
+	return gl;
+}
+// a fresh context reporting major.minor with extensions
+inline void ResetFakeGL(int major, int minor, std::vector<std::string> extensions = {}) {
+	FakeGL() = FAKE_GL();
+	FakeGL().major = major;
+	FakeGL().minor = minor;
+	FakeGL().extensions = std::move(extensions);
+}
+
+inline bool HasOGLExtension(const char* extension) {
+	for (const std::string& name : FakeGL().extensions) {
+		if (name == extension)
+			return true;
+	}
+	return false;
+}
+inline bool HasOGLVersion(int major, int minor) {
+	return FakeGL().major > major || (FakeGL().major == major && FakeGL().minor >= minor);
+}
+
+inline void glGenBuffers(GLsizei count, GLuint* ids) {
+	for (GLsizei i = 0; i < count; ++i) {
+		ids[i] = FakeGL().nextId++;
+		FakeGL().buffers[ids[i]];
+	}
+}
+inline void glDeleteBuffers(GLsizei count, const GLuint* ids) {
+	for (GLsizei i = 0; i < count; ++i)
+		FakeGL().buffers.erase(ids[i]);
+}
+inline void glBindBuffer(GLenum target, GLuint id) {
+	FakeGL().bound[target] = id;
+}
+inline void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum) {
+	FAKE_GL::BUFFER& buffer = FakeGL().Bound(target);
+	buffer.bytes.assign(static_cast<size_t>(size), 0);
+	if (data != nullptr)
+		std::memcpy(buffer.bytes.data(), data, static_cast<size_t>(size));
+}
+inline void FakeBufferStorage(GLenum target, GLsizeiptr size, const void*, GLbitfield) {
+	FAKE_GL::BUFFER& buffer = FakeGL().Bound(target);
+	buffer.bytes.assign(static_cast<size_t>(size), 0);
+	buffer.immutable = true;
+}
+// a pointer like the loaded one in OpenGLExtensions.h, so a test can leave it nullptr
+inline void (*glBufferStorage)(GLenum, GLsizeiptr, const void*, GLbitfield) = FakeBufferStorage;
+inline void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield flags) {
+	FAKE_GL::BUFFER& buffer = FakeGL().Bound(target);
+	if (buffer.mapped || offset < 0 || static_cast<size_t>(offset + length) > buffer.bytes.size())
+		return nullptr;
+	buffer.mapped = true;
+	buffer.mapFlags = flags;
+	++FakeGL().maps;
+	return buffer.bytes.data() + offset;
+}
+inline GLboolean glUnmapBuffer(GLenum target) {
+	FAKE_GL::BUFFER& buffer = FakeGL().Bound(target);
+	GLboolean wasMapped = buffer.mapped;
+	buffer.mapped = false;
+	++FakeGL().unmaps;
+	return wasMapped;
+}
+inline GLsync glFenceSync(GLenum, GLbitfield) {
+	FakeGL().lastFence = FakeGL().nextFence++;
+	return reinterpret_cast<GLsync>(FakeGL().lastFence);
+}
+inline GLenum glClientWaitSync(GLsync fence, GLbitfield, GLuint64) {
+	FakeGL().waitedOn.push_back(reinterpret_cast<uintptr_t>(fence));
+	return GL_ALREADY_SIGNALED;
+}
+inline void glDeleteSync(GLsync fence) {
+	FakeGL().deleted.push_back(reinterpret_cast<uintptr_t>(fence));
+}
@@ -0,0 +1,190 @@
+// FrustumCuller against a double precision reference and the boxes' own corners. Built once with the SIMD width
+// the compiler picks and once as FrustumCullerScalarTest with FRUSTUM_CULL_WIDTH 1, both have to give the same answers.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+// the parts of Gateware's math types FrustumCuller reads
+namespace GW {
+	namespace MATH {
+		struct GVECTORF {
+			float x, y, z, w;
+		};
+		struct GMATRIXF {
+			float data[16];
+		};
+		struct GOBBF {
+			GVECTORF center, extent, rotation;
+		};
+	}
+}
+#include "../FrustumCuller.h"
+#include "Check.h"
+
+using GW::MATH::GMATRIXF;
+using GW::MATH::GOBBF;
+
+// row vectors like GMatrix, a * b applies a first
+static GMATRIXF Multiply(const GMATRIXF& a, const GMATRIXF& b) {
+	GMATRIXF out = {};
+	for (int row = 0; row < 4; ++row)
+		for (int column = 0; column < 4; ++column)
+			for (int k = 0; k < 4; ++k)
+				out.data[row * 4 + column] += a.data[row * 4 + k] * b.data[k * 4 + column];
+	return out;
+}
+static GMATRIXF Identity() {
+	GMATRIXF out = {};
+	out.data[0] = out.data[5] = out.data[10] = out.data[15] = 1.0f;
+	return out;
+}
+static GMATRIXF Translation(float x, float y, float z) {
+	GMATRIXF out = Identity();
+	out.data[12] = x;
+	out.data[13] = y;
+	out.data[14] = z;
+	return out;
+}
+static GMATRIXF Scale(float x, float y, float z) {
+	GMATRIXF out = Identity();
+	out.data[0] = x;
+	out.data[5] = y;
+	out.data[10] = z;
+	return out;
+}
+// angle radians about a unit axis
+static GMATRIXF Rotation(float x, float y, float z, float angle) {
+	float c = std::cos(angle), s = std::sin(angle), t = 1.0f - c;
+	GMATRIXF out = Identity();
+	float m[9] = { t * x * x + c, t * x * y + s * z, t * x * z - s * y,
+		t * x * y - s * z, t * y * y + c, t * y * z + s * x,
+		t * x * z + s * y, t * y * z - s * x, t * z * z + c };
+	for (int row = 0; row < 3; ++row)
+		for (int column = 0; column < 3; ++column)
+			out.data[row * 4 + column] = m[row * 3 + column];
+	return out;
+}
+// right handed OpenGL projection, the same layout GMatrix::ProjectionOpenGLRHF makes
+static GMATRIXF Projection(float fovY, float aspect, float nearPlane, float farPlane) {
+	GMATRIXF out = {};
+	float f = 1.0f / std::tan(fovY * 0.5f);
+	out.data[0] = f / aspect;
+	out.data[5] = f;
+	out.data[10] = (farPlane + nearPlane) / (nearPlane - farPlane);
+	out.data[11] = -1.0f;
+	out.data[14] = 2.0f * farPlane * nearPlane / (nearPlane - farPlane);
+	return out;
+}
+
+struct BOX {
+	GOBBF bounds;
+	GMATRIXF toWorld;
+};
+// How far the box placed by toWorld reaches past the worst plane, worked out in double precision.
+// Negative means the world space box FrustumCuller builds is entirely outside one of the planes.
+static double Reach(const BOX& box, const GMATRIXF& viewProjection) {
+	const float* m = box.toWorld.data;
+	const float* v = viewProjection.data;
+	double center[3], extent[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		center[axis] = double(box.bounds.center.x) * m[axis] + double(box.bounds.center.y) * m[4 + axis] +
+			double(box.bounds.center.z) * m[8 + axis] + m[12 + axis];
+		extent[axis] = double(box.bounds.extent.x) * std::fabs(m[axis]) + double(box.bounds.extent.y) * std::fabs(m[4 + axis]) +
+			double(box.bounds.extent.z) * std::fabs(m[8 + axis]);
+	}
+	double worst = 1e30;
+	for (int plane = 0; plane < 6; ++plane) {
+		int axis = plane / 2;
+		double sign = plane % 2 == 0 ? 1.0 : -1.0;
+		double p[4];
+		for (int row = 0; row < 4; ++row)
+			p[row] = double(v[row * 4 + 3]) + sign * v[row * 4 + axis];
+		double distance = center[0] * p[0] + center[1] * p[1] + center[2] * p[2] + p[3];
+		double reach = extent[0] * std::fabs(p[0]) + extent[1] * std::fabs(p[1]) + extent[2] * std::fabs(p[2]);
+		// normalized so the margin below is a world distance whatever the plane's scale
+		double length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+		worst = std::fmin(worst, (distance + reach) / length);
+	}
+	return worst;
+}
+// true when one of the box's corners lands inside the clip volume, a box like that must never be culled
+static bool CornerInside(const BOX& box, const GMATRIXF& viewProjection) {
+	GMATRIXF toClip = Multiply(box.toWorld, viewProjection);
+	for (int corner = 0; corner < 8; ++corner) {
+		double p[3] = { box.bounds.center.x + ((corner & 1) ? box.bounds.extent.x : -box.bounds.extent.x),
+			box.bounds.center.y + ((corner & 2) ? box.bounds.extent.y : -box.bounds.extent.y),
+			box.bounds.center.z + ((corner & 4) ? box.bounds.extent.z : -box.bounds.extent.z) };
+		double clip[4];
+		for (int column = 0; column < 4; ++column)
+			clip[column] = p[0] * toClip.data[column] + p[1] * toClip.data[4 + column] + p[2] * toClip.data[8 + column] + toClip.data[12 + column];
+		if (std::fabs(clip[0]) < clip[3] && std::fabs(clip[1]) < clip[3] && std::fabs(clip[2]) < clip[3])
+			return true;
+	}
+	return false;
+}
+
+int main() {
+	// a camera at (3, 2, 10) turned a little to the left, looking down -z
+	GMATRIXF view = Multiply(Translation(-3.0f, -2.0f, -10.0f), Rotation(0.0f, 1.0f, 0.0f, 0.3f));
+	GMATRIXF viewProjection = Multiply(view, Projection(1.2f, 16.0f / 9.0f, 0.1f, 60.0f));
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<BOX> boxes;
+	for (int i = 0; i < 2000; ++i) {
+		BOX box;
+		box.bounds.center = { unit(random) * 0.5f, unit(random) * 0.5f, unit(random) * 0.5f, 0.0f };
+		box.bounds.extent = { 0.1f + std::fabs(unit(random)), 0.1f + std::fabs(unit(random)), 0.1f + std::fabs(unit(random)), 0.0f };
+		float x = unit(random), y = unit(random), z = unit(random);
+		float length = std::sqrt(x * x + y * y + z * z) + 1e-6f;
+		// mirrored and stretched like the level's walls, spread well past every side of the frustum
+		GMATRIXF scale = Scale(unit(random) * 3.0f + (random() % 2 ? 0.2f : -0.2f), unit(random) * 3.0f + 0.2f, 1.0f);
+		box.toWorld = Multiply(Multiply(scale, Rotation(x / length, y / length, z / length, unit(random) * 3.14f)),
+			Translation(unit(random) * 60.0f, unit(random) * 40.0f, unit(random) * 80.0f - 20.0f));
+		boxes.push_back(box);
+	}
+
+	FrustumCuller culler;
+	culler.SetViewProjection(viewProjection);
+	std::vector<unsigned char> visible;
+	// every count up to a few batches so the padding lanes of the last one are covered, then the whole set
+	std::vector<size_t> counts;
+	for (size_t count = 0; count <= 3 * 8 + 1; ++count)
+		counts.push_back(count);
+	counts.push_back(boxes.size());
+	size_t inside = 0, outside = 0, cornersInside = 0;
+	for (size_t count : counts) {
+		culler.Clear();
+		for (size_t i = 0; i < count; ++i)
+			culler.Add(boxes[i].bounds, boxes[i].toWorld);
+		culler.Test(visible);
+		CHECK(visible.size() == count);
+		CHECK(culler.TestedCount() == count);
+		size_t shown = 0;
+		for (size_t i = 0; i < count; ++i) {
+			shown += visible[i];
+			CHECK(visible[i] == 0 || visible[i] == 1);
+			// the float paths only get a say within a hair of a plane
+			double reach = Reach(boxes[i], viewProjection);
+			if (reach > 1e-3)
+				CHECK(visible[i] == 1);
+			else if (reach < -1e-3)
+				CHECK(visible[i] == 0);
+			// never cull something the camera can actually see part of
+			if (CornerInside(boxes[i], viewProjection))
+				CHECK(visible[i] == 1);
+			if (count == boxes.size()) {
+				inside += reach > 1e-3;
+				outside += reach < -1e-3;
+				cornersInside += CornerInside(boxes[i], viewProjection);
+			}
+		}
+		CHECK(culler.VisibleCount() == shown);
+	}
+	// the set is only worth anything if it has plenty on both sides
+	CHECK(inside > 200);
+	CHECK(outside > 200);
+	CHECK(cornersInside > 100);
+	return Failures();
+}
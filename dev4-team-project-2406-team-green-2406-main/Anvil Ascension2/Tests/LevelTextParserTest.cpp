@@ -0,0 +1,120 @@
+// LevelText::Parser against a small level written the way the blender exporter writes them
+
+#include "../LevelTextParser.h"
+#include "Check.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const char LEVEL[] =
+	"# Game Level Exporter v1.3\r\n"
+	"MESH\r\n"
+	"Floor\r\n"
+	"<Matrix 4x4 (-1.0000, 0.0000,  0.0000, 0.0000)\r\n"
+	"            ( 0.0000, 1.0000, -0.0000, 0.0000)\r\n"
+	"            ( 0.0000, 0.0000,  1.0000, 0.0000)\r\n"
+	"            (-0.0092, 0.2056,  0.0036, 1.0000)>\r\n"
+	"TEXTURE\r\n"
+	"..\\Textures\\Stone.jpg\r\n"
+	"<Vector (-3.7281, -0.2927, -3.7409)>\r\n"
+	"<Vector (-3.7281, -0.2927, 3.7337)>\r\n"
+	"<Vector (-3.7281, 0.1494, 3.7337)>\r\n"
+	"<Vector (-3.7281, 0.1494, -3.7409)>\r\n"
+	"<Vector (3.7465, -0.2927, -3.7409)>\r\n"
+	"<Vector (3.7465, -0.2927, 3.7337)>\r\n"
+	"<Vector (3.7465, 0.1494, 3.7337)>\r\n"
+	"<Vector (3.7465, 0.1494, -3.7409)>\r\n"
+	"LIGHT\r\n"
+	"SUN\r\n"
+	"Color: (1.0000, 0.9000, 0.8000)\r\n"
+	"Direction: (0.0000, -1.0000, 0.5000)\r\n"
+	"MESH\r\n"
+	"Wall_Cube.354\r\n"
+	"<Matrix 4x4 (-2.9320, 0.0000,  0.0000, 0.0000)\r\n"
+	"            ( 0.0000, 2.7843,  0.0000, 0.0000)\r\n"
+	"            ( 0.0000, 0.0000,  1.0000, 0.0000)\r\n"
+	"            ( 7.3589, 4.9583, -6.9258, 1.0000)>\r\n"
+	"MESH\r\n"
+	"Floor_Squares_Cube.035\r\n"
+	"<Matrix 4x4 (1.0000, 0.0000, 0.0000, 0.0000)\r\n"
+	"            (0.0000, 1.0000, 0.0000, 0.0000)\r\n"
+	"            (0.0000, 0.0000, 1.0000, 0.0000)\r\n"
+	"            (0.0000, 0.0000, 0.0000, 1.0000)>\r\n"
+	"\r\n"
+	"MESH\r\n"
+	"PastTheEnd\r\n";
+
+struct MESH_COPY {
+	std::string blenderName, modelName, texturePath;
+	float transform[16];
+	float bounds[8][3];
+	bool hasBounds;
+};
+
+int main() {
+	const char* path = "LevelTextParserTest.txt";
+	FILE* out = std::fopen(path, "wb");
+	CHECK(out != nullptr);
+	if (out == nullptr)
+		return Failures();
+	std::fwrite(LEVEL, 1, sizeof(LEVEL) - 1, out);
+	std::fclose(out);
+
+	LevelText::Parser parser;
+	CHECK(parser.Load(path));
+	CHECK(parser.Size() == sizeof(LEVEL) - 1);
+	std::vector<MESH_COPY> meshes;
+	std::vector<LevelText::LIGHT> lights;
+	parser.Parse([&meshes](const LevelText::MESH& mesh) {
+		MESH_COPY copy = {};
+		copy.blenderName = mesh.blenderName;
+		copy.modelName = mesh.ModelName();
+		copy.texturePath = mesh.texturePath;
+		std::copy(mesh.transform, mesh.transform + 16, copy.transform);
+		std::copy(&mesh.bounds[0][0], &mesh.bounds[0][0] + 24, &copy.bounds[0][0]);
+		copy.hasBounds = mesh.hasBounds;
+		meshes.push_back(copy);
+	}, [&lights](const LevelText::LIGHT& light) {
+		lights.push_back(light);
+	});
+	std::remove(path);
+
+	// the empty line ends the level, PastTheEnd is never read
+	CHECK(meshes.size() == 3);
+	if (meshes.size() != 3)
+		return Failures();
+
+	// carriage returns are stripped, TEXTURE and bounds belong to the MESH before them
+	CHECK(meshes[0].blenderName == "Floor");
+	CHECK(meshes[0].modelName == "Floor");
+	CHECK(meshes[0].texturePath == "..\\Textures\\Stone.jpg");
+	CHECK(meshes[0].transform[0] == -1.0f);
+	CHECK(meshes[0].transform[13] == 0.2056f);
+	CHECK(meshes[0].transform[15] == 1.0f);
+	CHECK(meshes[0].hasBounds);
+	CHECK(meshes[0].bounds[0][0] == -3.7281f && meshes[0].bounds[0][1] == -0.2927f && meshes[0].bounds[0][2] == -3.7409f);
+	CHECK(meshes[0].bounds[7][0] == 3.7465f && meshes[0].bounds[7][1] == 0.1494f && meshes[0].bounds[7][2] == -3.7409f);
+
+	// no TEXTURE and no bounds, the .354 copy suffix doesn't end up in the model name
+	CHECK(meshes[1].blenderName == "Wall_Cube.354");
+	CHECK(meshes[1].modelName == "Wall_Cube");
+	CHECK(meshes[1].texturePath.empty());
+	CHECK(meshes[1].hasBounds == false);
+	CHECK(meshes[1].transform[0] == -2.9320f);
+	CHECK(meshes[1].transform[12] == 7.3589f && meshes[1].transform[14] == -6.9258f);
+
+	CHECK(meshes[2].modelName == "Floor_Squares_Cube");
+	CHECK(meshes[2].transform[5] == 1.0f && meshes[2].transform[10] == 1.0f);
+
+	CHECK(lights.size() == 1);
+	if (lights.size() == 1) {
+		CHECK(lights[0].type == "SUN");
+		CHECK(lights[0].color[0] == 1.0f && lights[0].color[1] == 0.9f && lights[0].color[2] == 0.8f);
+		CHECK(lights[0].direction[1] == -1.0f && lights[0].direction[2] == 0.5f);
+	}
+
+	// a missing file fails the Load
+	CHECK(parser.Load("LevelTextParserTest.missing") == false);
+	return Failures();
+}
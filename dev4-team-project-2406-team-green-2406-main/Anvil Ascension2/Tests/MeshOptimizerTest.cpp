@@ -0,0 +1,105 @@
+// MeshOptimizer has to keep every triangle and its winding, and must never leave ACMR worse than it found it
+
+#include "../MeshOptimizer.h"
+#include "Check.h"
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+// triangles rotated so the smallest index leads, sorted, order independent but winding sensitive
+static std::vector<std::array<unsigned, 3>> Triangles(const std::vector<unsigned>& indices, const std::vector<H2B::VERTEX>* vertices = nullptr) {
+	std::vector<std::array<unsigned, 3>> out;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		std::array<unsigned, 3> t = { indices[i], indices[i + 1], indices[i + 2] };
+		if (vertices != nullptr) {
+			// after OptimizeVertexFetch the numbers change, compare through a position hash instead
+			for (unsigned& v : t) {
+				const H2B::VERTEX& vertex = (*vertices)[v];
+				v = static_cast<unsigned>(vertex.pos.x * 1000.0f) * 100000u + static_cast<unsigned>(vertex.pos.y * 1000.0f);
+			}
+		}
+		std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+		out.push_back(t);
+	}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+// a side x side grid of quads in the xy plane, two triangles each, in row order
+static void Grid(unsigned side, std::vector<H2B::VERTEX>& vertices, std::vector<unsigned>& indices) {
+	vertices.clear();
+	indices.clear();
+	for (unsigned y = 0; y <= side; ++y)
+		for (unsigned x = 0; x <= side; ++x) {
+			H2B::VERTEX vertex = {};
+			vertex.pos = { static_cast<float>(x), static_cast<float>(y), 0.0f };
+			vertex.nrm = { 0.0f, 0.0f, 1.0f };
+			vertices.push_back(vertex);
+		}
+	for (unsigned y = 0; y < side; ++y)
+		for (unsigned x = 0; x < side; ++x) {
+			unsigned corner = y * (side + 1) + x;
+			indices.insert(indices.end(), { corner, corner + 1, corner + side + 2, corner, corner + side + 2, corner + side + 1 });
+		}
+}
+
+static void ShuffleTriangles(std::vector<unsigned>& indices, std::mt19937& random) {
+	std::vector<std::array<unsigned, 3>> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+		triangles.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+	std::shuffle(triangles.begin(), triangles.end(), random);
+	indices.clear();
+	for (const std::array<unsigned, 3>& t : triangles)
+		indices.insert(indices.end(), t.begin(), t.end());
+}
+
+int main() {
+	// the FIFO model itself
+	std::vector<unsigned> strip = { 0, 1, 2, 1, 3, 2, 2, 3, 4 };
+	CHECK(MeshOptimizer::ACMR(strip.data(), strip.size()) == 5.0f / 3.0f);
+	std::vector<unsigned> unshared = { 0, 1, 2, 3, 4, 5 };
+	CHECK(MeshOptimizer::ACMR(unshared.data(), unshared.size()) == 3.0f);
+
+	std::mt19937 random(11);
+	std::vector<H2B::VERTEX> vertices;
+	std::vector<unsigned> indices;
+	for (unsigned side : { 8u, 32u, 100u }) {
+		// a scrambled grid gets much better, an already ordered one doesn't get worse
+		for (bool shuffled : { true, false }) {
+			Grid(side, vertices, indices);
+			if (shuffled)
+				ShuffleTriangles(indices, random);
+			std::vector<unsigned> original = indices;
+			float before = MeshOptimizer::ACMR(indices.data(), indices.size());
+			MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), static_cast<unsigned>(vertices.size()));
+			float cached = MeshOptimizer::ACMR(indices.data(), indices.size());
+			CHECK(Triangles(indices) == Triangles(original));
+			CHECK(cached <= before);
+			if (shuffled && side >= 32)
+				CHECK(cached < 0.8f); // a regular grid should get close to the ~0.5 best case
+			// overdraw sorting is allowed to give a little back but never more than its threshold
+			MeshOptimizer::OptimizeOverdraw(indices.data(), indices.size(), vertices.data());
+			float sorted = MeshOptimizer::ACMR(indices.data(), indices.size());
+			CHECK(Triangles(indices) == Triangles(original));
+			CHECK(sorted <= cached * 1.05f + 1e-6f);
+			CHECK(sorted <= before);
+
+			// fetch order renumbers the vertices but leaves the triangles and the cache behaviour alone
+			std::vector<unsigned> beforeFetch = indices;
+			std::vector<H2B::VERTEX> originalVertices = vertices;
+			MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+			CHECK(Triangles(indices, &vertices) == Triangles(beforeFetch, &originalVertices));
+			CHECK(MeshOptimizer::ACMR(indices.data(), indices.size()) == sorted);
+			// first use order means each index is at most one past the largest one before it
+			unsigned next = 0;
+			bool ordered = true;
+			for (unsigned index : indices) {
+				ordered = ordered && index <= next;
+				next = std::max(next, index + 1);
+			}
+			CHECK(ordered);
+		}
+	}
+	return Failures();
+}
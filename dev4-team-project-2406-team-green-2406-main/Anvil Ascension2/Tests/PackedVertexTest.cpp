@@ -0,0 +1,88 @@
+// The .h2b2 vertex conversions: half floats, 2_10_10_10 normals, whole PackVertex/UnpackVertex round trips and MeasureBounds
+
+#include "../h2bParser.h"
+#include "Check.h"
+#include <cmath>
+#include <random>
+
+int main() {
+	// exact half encodings
+	CHECK(H2B::FloatToHalf(0.0f) == 0x0000);
+	CHECK(H2B::FloatToHalf(-0.0f) == 0x8000);
+	CHECK(H2B::FloatToHalf(1.0f) == 0x3C00);
+	CHECK(H2B::FloatToHalf(0.5f) == 0x3800);
+	CHECK(H2B::FloatToHalf(-2.0f) == 0xC000);
+	CHECK(H2B::FloatToHalf(65504.0f) == 0x7BFF); // largest half
+	CHECK(H2B::FloatToHalf(1.0e6f) == 0x7C00); // too big, infinity
+	CHECK(H2B::FloatToHalf(std::ldexp(1.0f, -24)) == 0x0001); // smallest denormal
+	CHECK(H2B::FloatToHalf(std::ldexp(1.0f, -30)) == 0x0000); // flushed
+	CHECK(H2B::HalfToFloat(0x3C00) == 1.0f);
+	CHECK(H2B::HalfToFloat(0xC000) == -2.0f);
+	CHECK(H2B::HalfToFloat(0x0001) == std::ldexp(1.0f, -24));
+	CHECK(std::isinf(H2B::HalfToFloat(0x7C00)));
+
+	// every finite half survives a trip through float
+	for (unsigned half = 0; half < 0x10000; ++half) {
+		if (((half >> 10) & 0x1F) == 0x1F)
+			continue; // inf and nan
+		CHECK(H2B::FloatToHalf(H2B::HalfToFloat(static_cast<unsigned short>(half))) == half);
+	}
+	// texture coordinates in the usual range are within half a half-ulp
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> uv(-4.0f, 4.0f);
+	for (int i = 0; i < 10000; ++i) {
+		float value = uv(random);
+		float back = H2B::HalfToFloat(H2B::FloatToHalf(value));
+		CHECK(std::fabs(back - value) <= std::ldexp(1.0f, -10));
+	}
+
+	// signed 10 bit fields, x in the low bits
+	CHECK(H2B::PackSnorm10x3(1.0f, 0.0f, 0.0f) == 511u);
+	CHECK(H2B::PackSnorm10x3(0.0f, 1.0f, 0.0f) == 511u << 10);
+	CHECK(H2B::PackSnorm10x3(0.0f, 0.0f, -1.0f) == 0x201u << 20); // -511 in 10 bit two's complement
+	CHECK(H2B::PackSnorm10x3(2.0f, -2.0f, 0.0f) == (511u | (0x201u << 10))); // clamped
+	float unpacked[3];
+	H2B::UnpackSnorm10x3(H2B::PackSnorm10x3(-1.0f, 0.5f, 0.25f), unpacked);
+	CHECK(unpacked[0] == -1.0f);
+	CHECK(std::fabs(unpacked[1] - 0.5f) <= 0.5f / 511.0f);
+	CHECK(std::fabs(unpacked[2] - 0.25f) <= 0.5f / 511.0f);
+	H2B::UnpackSnorm10x3(0x200u, unpacked); // -512 reads as -1 like GL does
+	CHECK(unpacked[0] == -1.0f);
+
+	// whole vertices inside non-uniform bounds
+	const float center[3] = { 1.0f, -2.0f, 0.5f }, extent[3] = { 3.0f, 0.25f, 1.0f };
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for (int i = 0; i < 10000; ++i) {
+		H2B::VERTEX vertex = {};
+		vertex.pos = { center[0] + extent[0] * unit(random), center[1] + extent[1] * unit(random), center[2] + extent[2] * unit(random) };
+		vertex.uvw = { unit(random), unit(random), 0.0f };
+		float n[3] = { unit(random), unit(random), unit(random) };
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length < 0.01f)
+			continue;
+		vertex.nrm = { n[0] / length, n[1] / length, n[2] / length };
+		H2B::VERTEX back = H2B::UnpackVertex(H2B::PackVertex(vertex, center, extent), center, extent);
+		// snorm16 steps are extent / 32767
+		CHECK(std::fabs(back.pos.x - vertex.pos.x) <= extent[0] / 32767.0f);
+		CHECK(std::fabs(back.pos.y - vertex.pos.y) <= extent[1] / 32767.0f);
+		CHECK(std::fabs(back.pos.z - vertex.pos.z) <= extent[2] / 32767.0f);
+		CHECK(std::fabs(back.uvw.x - vertex.uvw.x) <= std::ldexp(1.0f, -11));
+		CHECK(std::fabs(back.uvw.y - vertex.uvw.y) <= std::ldexp(1.0f, -11));
+		// the normal comes back unit length and within a couple of degrees
+		float dot = back.nrm.x * vertex.nrm.x + back.nrm.y * vertex.nrm.y + back.nrm.z * vertex.nrm.z;
+		float backLength = std::sqrt(back.nrm.x * back.nrm.x + back.nrm.y * back.nrm.y + back.nrm.z * back.nrm.z);
+		CHECK(std::fabs(backLength - 1.0f) < 1.0e-4f);
+		CHECK(dot > 0.999f);
+	}
+
+	// bounds the level loader packs uncooked models against, a flat axis still gets an extent to divide by
+	H2B::VERTEX quad[3] = {};
+	quad[0].pos = { -1.0f, 2.0f, 5.0f };
+	quad[1].pos = { 3.0f, 2.0f, -1.0f };
+	quad[2].pos = { 0.0f, 2.0f, 0.0f };
+	float measuredCenter[3], measuredExtent[3];
+	H2B::MeasureBounds(quad, 3, measuredCenter, measuredExtent);
+	CHECK(measuredCenter[0] == 1.0f && measuredCenter[1] == 2.0f && measuredCenter[2] == 2.0f);
+	CHECK(measuredExtent[0] == 2.0f && measuredExtent[1] == 1.0f && measuredExtent[2] == 3.0f);
+	return Failures();
+}
@@ -0,0 +1,93 @@
+// RenderQueue: key packing order, the radix sort against std::stable_sort and the change masks Submit reports
+
+#include "../RenderQueue.h"
+#include "Check.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// pushes items, sorts them and returns the indices in the order Submit hands them out
+static std::vector<unsigned> SortedIndices(RenderQueue& queue, const std::vector<uint64_t>& keys) {
+	queue.Clear();
+	for (unsigned i = 0; i < keys.size(); ++i)
+		queue.Push(keys[i], i);
+	queue.Sort();
+	std::vector<unsigned> order;
+	queue.Submit([&order](unsigned index, unsigned) { order.push_back(index); });
+	return order;
+}
+// what a stable sort by key gives
+static std::vector<unsigned> ExpectedIndices(const std::vector<uint64_t>& keys) {
+	std::vector<unsigned> order(keys.size());
+	for (unsigned i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&keys](unsigned a, unsigned b) { return keys[a] < keys[b]; });
+	return order;
+}
+
+int main() {
+	using Q = RenderQueue;
+	// higher fields outrank everything below them, depth goes front to back
+	CHECK(Q::MakeKey(0, 9, 9, 9, 1.0f) < Q::MakeKey(1, 0, 0, 0, 0.0f));
+	CHECK(Q::MakeKey(0, 0, 9, 9, 1.0f) < Q::MakeKey(0, 1, 0, 0, 0.0f));
+	CHECK(Q::MakeKey(0, 0, 0, 9, 1.0f) < Q::MakeKey(0, 0, 1, 0, 0.0f));
+	CHECK(Q::MakeKey(0, 0, 0, 0, 1.0f) < Q::MakeKey(0, 0, 0, 1, 0.0f));
+	CHECK(Q::MakeKey(0, 0, 0, 0, 0.25f) < Q::MakeKey(0, 0, 0, 0, 0.5f));
+	// depth is clamped to the planes, ids wider than their field are cut down instead of spilling upward
+	CHECK(Q::MakeKey(0, 0, 0, 0, -3.0f) == Q::MakeKey(0, 0, 0, 0, 0.0f));
+	CHECK(Q::MakeKey(0, 0, 0, 0, 7.0f) == Q::MakeKey(0, 0, 0, 0, 1.0f));
+	CHECK(Q::MakeKey(0, 0, 0, 1u << Q::MESH_BITS, 0.0f) == Q::MakeKey(0, 0, 0, 0, 0.0f));
+	CHECK(Q::MakeKey(0, 0, 1u << Q::TEXTURE_BITS, 0, 0.0f) == Q::MakeKey(0, 0, 0, 0, 0.0f));
+	CHECK(Q::PASS_SHIFT + Q::PASS_BITS == 64);
+
+	RenderQueue queue;
+	// nothing and one item are left alone
+	CHECK(SortedIndices(queue, {}).empty());
+	CHECK((SortedIndices(queue, { 42 }) == std::vector<unsigned>{ 0 }));
+
+	// random keys drawn from a few states each, so runs of equal keys and bytes every key shares both show up
+	std::mt19937 random(7);
+	for (unsigned round = 0; round < 50; ++round) {
+		std::vector<uint64_t> keys(1 + random() % 500);
+		for (uint64_t& key : keys) {
+			key = Q::MakeKey(random() % 2, random() % 3, random() % (1 + round % 5), random() % 4,
+				static_cast<float>(random() % 8) / 7.0f);
+		}
+		CHECK(SortedIndices(queue, keys) == ExpectedIndices(keys));
+	}
+	// full width keys exercise every byte pass, keys differing only in their low bytes make the first passes count
+	std::vector<uint64_t> wide(1000), narrow(1000);
+	for (uint64_t& key : wide)
+		key = (static_cast<uint64_t>(random()) << 32) | random();
+	for (uint64_t& key : narrow)
+		key = random() % 4096;
+	CHECK(SortedIndices(queue, wide) == ExpectedIndices(wide));
+	CHECK(SortedIndices(queue, narrow) == ExpectedIndices(narrow));
+
+	// Submit reports what differs from the item before, a new program counts as every state changing
+	std::vector<uint64_t> keys = {
+		Q::MakeKey(0, 1, 1, 1, 0.1f), // first item, everything
+		Q::MakeKey(0, 1, 1, 1, 0.2f), // depth only, nothing
+		Q::MakeKey(0, 1, 1, 2, 0.0f), // mesh
+		Q::MakeKey(0, 1, 2, 2, 0.0f), // texture
+		Q::MakeKey(0, 2, 2, 2, 0.0f), // program, so texture and mesh too
+		Q::MakeKey(1, 2, 2, 2, 0.0f), // pass, same as a program change
+	};
+	queue.Clear();
+	for (unsigned i = 0; i < keys.size(); ++i)
+		queue.Push(keys[keys.size() - 1 - i], static_cast<unsigned>(keys.size() - 1 - i));
+	queue.Sort();
+	const unsigned all = Q::PROGRAM_CHANGED | Q::TEXTURE_CHANGED | Q::MESH_CHANGED;
+	std::vector<unsigned> expected = { all, 0, Q::MESH_CHANGED, Q::TEXTURE_CHANGED, all, all };
+	std::vector<unsigned> order, changes;
+	queue.Submit([&](unsigned index, unsigned changed) {
+		order.push_back(index);
+		changes.push_back(changed);
+	});
+	CHECK((order == std::vector<unsigned>{ 0, 1, 2, 3, 4, 5 }));
+	CHECK(changes == expected);
+	CHECK(queue.StateChangeCount() == 3 + 0 + 1 + 1 + 3 + 3);
+	CHECK(queue.StateChangesAvoided() == 0 + 3 + 2 + 2 + 0 + 0);
+	CHECK(queue.ItemCount() == keys.size());
+	return Failures();
+}
@@ -0,0 +1,127 @@
+// RingBuffer against the fake GL: section offsets and alignment, where writes land, fence waits and which path it takes
+
+#include "FakeGL.h"
+#include "../RingBuffer.h"
+#include "Check.h"
+#include <algorithm>
+#include <vector>
+
+// writes bytes of value into the ring and checks they show up in the buffer at the offset handed back
+static bool WriteAndFind(RingBuffer& ring, size_t bytes, unsigned char value, GLintptr& offset) {
+	std::vector<unsigned char> data(bytes, value);
+	if (ring.Write(data.data(), bytes, offset) == false)
+		return false;
+	ring.Flush();
+	const std::vector<unsigned char>& stored = FakeGL().buffers[ring.Id()].bytes;
+	for (size_t i = 0; i < bytes; ++i) {
+		if (stored[offset + i] != value)
+			return false;
+	}
+	return true;
+}
+
+int main() {
+	// GL 4.4: one persistent map for the buffer's whole life, sections rounded up to the alignment
+	ResetFakeGL(4, 4);
+	{
+		RingBuffer ring;
+		ring.Reserve(GL_UNIFORM_BUFFER, 1000, 256);
+		const size_t section = 1024;
+		CHECK(FakeGL().buffers[ring.Id()].immutable);
+		CHECK(FakeGL().buffers[ring.Id()].bytes.size() == section * RingBuffer::FRAMES);
+		CHECK((FakeGL().buffers[ring.Id()].mapFlags & GL_MAP_PERSISTENT_BIT) != 0);
+		for (unsigned frame = 0; frame < 6; ++frame) {
+			ring.BeginFrame();
+			GLintptr start = static_cast<GLintptr>(section * ((frame + 1) % RingBuffer::FRAMES));
+			GLintptr offsets[3];
+			CHECK(WriteAndFind(ring, 100, static_cast<unsigned char>(frame * 3 + 1), offsets[0]));
+			CHECK(WriteAndFind(ring, 10, static_cast<unsigned char>(frame * 3 + 2), offsets[1]));
+			CHECK(WriteAndFind(ring, 256, static_cast<unsigned char>(frame * 3 + 3), offsets[2]));
+			// each record starts on its own alignment boundary inside this frame's section
+			CHECK(offsets[0] == start);
+			CHECK(offsets[1] == start + 256);
+			CHECK(offsets[2] == start + 512);
+			for (GLintptr offset : offsets)
+				CHECK(offset % 256 == 0);
+			// 768 bytes are spoken for, 300 more would run into the next section
+			GLintptr full = -1;
+			CHECK(WriteAndFind(ring, 300, 0xFF, full) == false);
+			CHECK(WriteAndFind(ring, 256, 0xEE, full));
+			CHECK(full == start + 768);
+			ring.EndFrame();
+			CHECK(ring.LastFrameBytes() == 100 + 10 + 256 + 256);
+		}
+		CHECK(FakeGL().maps == 1);
+		// a section is only waited on once it comes round again, for the fence of the frame that last filled it
+		CHECK((FakeGL().waitedOn == std::vector<uintptr_t>{ 1, 2, 3 }));
+	}
+	// destroying it waits out the frames still in flight, in whatever order their sections come, and deletes the buffer
+	std::vector<uintptr_t> waited = FakeGL().waitedOn;
+	std::sort(waited.begin(), waited.end());
+	CHECK((waited == std::vector<uintptr_t>{ 1, 2, 3, 4, 5, 6 }));
+	CHECK(FakeGL().deleted.size() == 6);
+	CHECK(FakeGL().buffers.empty());
+
+	// GL 4.3: each frame's section is mapped unsynchronized and has to be flushed before drawing
+	ResetFakeGL(4, 3);
+	{
+		RingBuffer ring;
+		ring.Reserve(GL_ARRAY_BUFFER, 64, 16);
+		CHECK(FakeGL().buffers[ring.Id()].immutable == false);
+		CHECK(FakeGL().buffers[ring.Id()].bytes.size() == 64 * RingBuffer::FRAMES);
+		GLintptr offset = -1;
+		CHECK(ring.Allocate(16, offset) == nullptr); // nothing mapped before the first BeginFrame
+		for (unsigned frame = 0; frame < 4; ++frame) {
+			ring.BeginFrame();
+			const FAKE_GL::BUFFER& buffer = FakeGL().buffers[ring.Id()];
+			CHECK(buffer.mapped);
+			CHECK((buffer.mapFlags & GL_MAP_UNSYNCHRONIZED_BIT) != 0);
+			CHECK((buffer.mapFlags & GL_MAP_PERSISTENT_BIT) == 0);
+			CHECK(WriteAndFind(ring, 40, static_cast<unsigned char>(frame + 1), offset));
+			CHECK(offset == static_cast<GLintptr>(64 * ((frame + 1) % RingBuffer::FRAMES)));
+			CHECK(buffer.mapped == false);
+			CHECK(WriteAndFind(ring, 8, 0xFF, offset) == false); // flushed, nothing more this frame
+			ring.EndFrame();
+		}
+		CHECK(FakeGL().maps == 4);
+		CHECK(FakeGL().unmaps == 4);
+	}
+
+	// an older version with the extension still gets persistent storage
+	ResetFakeGL(3, 3, { "GL_ARB_buffer_storage" });
+	{
+		RingBuffer ring;
+		ring.Reserve(GL_ARRAY_BUFFER, 64, 16);
+		CHECK(FakeGL().buffers[ring.Id()].immutable);
+	}
+	// and a new enough version without the entry point doesn't
+	ResetFakeGL(4, 6);
+	auto storage = glBufferStorage;
+	glBufferStorage = nullptr;
+	{
+		RingBuffer ring;
+		ring.Reserve(GL_ARRAY_BUFFER, 64, 16);
+		CHECK(FakeGL().buffers[ring.Id()].immutable == false);
+	}
+	glBufferStorage = storage;
+
+	// no alignment packs records back to back, Reserve only reallocates when the frame outgrows its section
+	ResetFakeGL(4, 6);
+	{
+		RingBuffer ring;
+		ring.Reserve(GL_ARRAY_BUFFER, 30, 0);
+		GLuint first = ring.Id();
+		ring.BeginFrame();
+		GLintptr a = -1, b = -1;
+		CHECK(WriteAndFind(ring, 7, 1, a));
+		CHECK(WriteAndFind(ring, 5, 2, b));
+		CHECK(b == a + 7);
+		ring.EndFrame();
+		ring.Reserve(GL_ARRAY_BUFFER, 20, 0);
+		CHECK(ring.Id() == first);
+		ring.Reserve(GL_ARRAY_BUFFER, 31, 0);
+		CHECK(FakeGL().buffers.count(first) == 0);
+		CHECK(FakeGL().buffers[ring.Id()].bytes.size() == 31 * RingBuffer::FRAMES);
+	}
+	return Failures();
+}
@@ -0,0 +1,118 @@
+#pragma once
+// A .texb file is a .jpg/.png cooked ahead of time by the TextureCooker tool.
+// Every mip level is already built and stored in upload order, loading one is a memory map instead of
+// an image decode plus glGenerateMipmap.
+
+#include "MappedFile.h"
+#include <string>
+
+namespace TEXB {
+
+	constexpr char MAGIC[4] = { 'T', 'E', 'X', 'B' };
+	constexpr unsigned VERSION = 1; // a .texb from any other version is skipped and the image decoded instead
+	constexpr char EXTENSION[] = ".texb"; // Textures/Stone.jpg -> Textures/Stone.texb
+	constexpr unsigned MAX_MIPS = 16; // 32768x32768
+	constexpr unsigned LEVEL_ALIGNMENT = 16;
+
+	enum FORMAT : unsigned {
+		FORMAT_RGB8 = 0, // tightly packed rows, 3 bytes a texel
+		FORMAT_BC1 = 1, // DXT1 4x4 blocks, 8 bytes each
+	};
+
+#pragma pack(push,1)
+	struct HEADER {
+		char magic[4];
+		unsigned version;
+		unsigned fileSize; // catches truncated copies
+		unsigned format; // FORMAT
+		unsigned width;
+		unsigned height;
+		unsigned mipCount;
+		unsigned reserved;
+	};
+	struct MIP { // follows the HEADER, one per level, largest first
+		unsigned offset; // from the start of the file, LEVEL_ALIGNMENT aligned
+		unsigned size; // bytes
+		unsigned width;
+		unsigned height;
+	};
+#pragma pack(pop)
+
+	// bytes one level takes in the given format
+	inline unsigned LevelSize(unsigned format, unsigned width, unsigned height) {
+		if (format == FORMAT_BC1)
+			return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+		return width * height * 3;
+	}
+
+	// A mapped .texb, every level points straight into the file
+	class Texture {
+		MappedFile file;
+		const HEADER* header = nullptr;
+	public:
+		// Maps a cooked texture, false if it's missing, truncated or from another VERSION
+		bool Open(const char* texbPath) {
+			Close();
+			if (file.Open(texbPath) == false)
+				return false;
+			header = reinterpret_cast<const HEADER*>(file.Data());
+			bool valid = file.Size() >= sizeof(HEADER) &&
+				header->magic[0] == MAGIC[0] && header->magic[1] == MAGIC[1] &&
+				header->magic[2] == MAGIC[2] && header->magic[3] == MAGIC[3] &&
+				header->version == VERSION && header->fileSize == file.Size() &&
+				(header->format == FORMAT_RGB8 || header->format == FORMAT_BC1) &&
+				header->mipCount > 0 && header->mipCount <= MAX_MIPS &&
+				file.Size() >= sizeof(HEADER) + sizeof(MIP) * header->mipCount;
+			// levels are uploaded without copying so every one has to land inside the file
+			for (unsigned i = 0; valid && i < header->mipCount; ++i) {
+				const MIP& mip = Mips()[i];
+				valid = mip.offset % LEVEL_ALIGNMENT == 0 && mip.offset <= file.Size() &&
+					mip.size <= file.Size() - mip.offset &&
+					mip.size == LevelSize(header->format, mip.width, mip.height);
+			}
+			if (valid == false)
+				Close();
+			return valid;
+		}
+
+		// Maps the .texb cooked from imagePath, false if there isn't one or the image has been edited since
+		bool OpenCooked(const char* imagePath) {
+			std::string cookedPath = CookedPath(imagePath, EXTENSION);
+			return IsCookedFileCurrent(cookedPath.c_str(), imagePath) && Open(cookedPath.c_str());
+		}
+
+		void Close() {
+			file.Close();
+			header = nullptr;
+		}
+		bool IsOpen() const {
+			return header != nullptr;
+		}
+
+		unsigned Format() const {
+			return header->format;
+		}
+		unsigned Width() const {
+			return header->width;
+		}
+		unsigned Height() const {
+			return header->height;
+		}
+		unsigned MipCount() const {
+			return header ? header->mipCount : 0;
+		}
+		const MIP* Mips() const {
+			return reinterpret_cast<const MIP*>(file.Data() + sizeof(HEADER));
+		}
+		const unsigned char* Level(unsigned mip) const {
+			return file.Data() + Mips()[mip].offset;
+		}
+		// bytes of every level together, what the upload stages
+		size_t DataSize() const {
+			size_t total = 0;
+			for (unsigned i = 0; i < MipCount(); ++i)
+				total += Mips()[i].size;
+			return total;
+		}
+	};
+}
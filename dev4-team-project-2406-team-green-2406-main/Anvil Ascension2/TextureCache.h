@@ -0,0 +1,487 @@
+#pragma once
+// Every Model that names the same image shares one GL texture.
+// Textures are reference counted, the last Release deletes the texture.
+// Images are decoded on GConcurrent worker threads and uploaded a few per frame by UploadFinished,
+// until then every TEXTURE shows a flat grey placeholder so loading never waits on stbi_load.
+// Uploads go through pixel buffer objects, the main thread only maps one and a worker copies the texels in,
+// so the glTex*Image calls read from the buffer and return without copying the image themselves.
+// An up to date .texb from TextureCooker is mapped instead, its baked mips go up without any decoding.
+// With UseArrays on, images of the same size and format become layers of one GL_TEXTURE_2D_ARRAY so
+// Models with different textures can be drawn without rebinding, TEXTURE::layer says which one.
+
+#include "TextureBinary.h"
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class TextureCache {
+	// filled in by a worker thread, the main thread only reads it once done is set
+	struct DECODE {
+		std::string path;
+		bool allowCompressed = false; // BC1 .texb files are only used when the driver can take them
+		TEXB::Texture cooked; // open when a .texb was used, pixels stays nullptr then
+		unsigned char* pixels = nullptr; // RGB8, nullptr if stbi_load failed
+		int width = 0, height = 0;
+		std::atomic<bool> done{ false };
+		// PBO the texels are staged in, mapped by the main thread and filled by a worker.
+		// 0 after a failed map, the upload then reads pixels or the .texb where they are.
+		GLuint pixelBuffer = 0;
+		unsigned char* mapped = nullptr;
+		bool stageStarted = false; // main thread only
+		std::atomic<bool> staged{ false };
+		~DECODE() {
+			if (pixels != nullptr)
+				stbi_image_free(pixels);
+		}
+	};
+	// one GL_TEXTURE_2D_ARRAY, sized when it's packed so it never grows
+	struct LAYERS {
+		GLuint id = 0;
+		unsigned width = 0, height = 0, format = TEXB::FORMAT_RGB8, mipCount = 1;
+		unsigned layerCount = 0;
+		unsigned waiting = 0; // layers not uploaded yet, none of them show until this reaches 0
+		bool generateMips = false; // an RGB8 layer came from a plain image, there's no baked chain for it
+		unsigned references = 0; // TEXTUREs placed in it
+	};
+public:
+	// one image, id is the placeholder until ready
+	struct TEXTURE {
+		GLuint id = 0;
+		int width = 0, height = 0;
+		bool ready = false;
+		unsigned references = 0;
+		// with UseArrays on id stays the placeholder and the image is this layer of array once ready
+		GLuint array = 0;
+		unsigned layer = 0;
+	private:
+		friend class TextureCache;
+		std::string path; // normalized, the key in byPath
+		std::shared_ptr<DECODE> decode; // shared with the worker so Release can't pull it out from under it
+		LAYERS* owner = nullptr;
+	};
+private:
+	std::unordered_map<std::string, TEXTURE> byPath; // node based so handed out pointers stay put
+	std::list<LAYERS> arrays; // list so owner pointers stay put
+	GW::SYSTEM::GConcurrent threads;
+	std::vector<std::shared_ptr<DECODE>> orphans; // released while a worker was still filling their PBO
+	GLuint placeholder = 0;
+	bool s3tc = false; // GL_EXT_texture_compression_s3tc, checked when the placeholder is made
+	bool useArrays = false;
+
+	static void SetSampling(GLenum target) {
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+	// levels down to 1x1, what glGenerateMipmap and TextureCooker both build
+	static unsigned FullMipCount(unsigned width, unsigned height) {
+		unsigned count = 1;
+		for (; (width > 1 || height > 1) && count < TEXB::MAX_MIPS; ++count) {
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+		return count;
+	}
+	void CreatePlaceholder() {
+		const unsigned char grey[3] = { 128, 128, 128 };
+		glGenTextures(1, &placeholder);
+		glBindTexture(GL_TEXTURE_2D, placeholder);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		SetSampling(GL_TEXTURE_2D);
+	}
+	// bytes UploadFinished counts against its budget
+	static size_t UploadSize(const DECODE& decoded) {
+		if (decoded.cooked.IsOpen())
+			return decoded.cooked.DataSize();
+		return static_cast<size_t>(decoded.width) * decoded.height * 3;
+	}
+	// Maps a PBO for a decoded image and has a worker copy every level into it back to back.
+	// If it can't be mapped staged is set straight away and the upload reads the texels where they are.
+	void Stage(const std::shared_ptr<DECODE>& decode) {
+		decode->stageStarted = true;
+		GLsizeiptr bytes = static_cast<GLsizeiptr>(UploadSize(*decode));
+		if (glMapBufferRange != nullptr && bytes > 0) {
+			glGenBuffers(1, &decode->pixelBuffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, decode->pixelBuffer);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+			decode->mapped = static_cast<unsigned char*>(
+				glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		if (decode->mapped == nullptr) {
+			FreeStaging(*decode);
+			decode->staged.store(true, std::memory_order_release);
+			return;
+		}
+		threads.BranchSingular([decode]() {
+			const TEXB::Texture& cooked = decode->cooked;
+			if (cooked.IsOpen()) {
+				size_t offset = 0;
+				for (unsigned i = 0; i < cooked.MipCount(); ++i) {
+					std::memcpy(decode->mapped + offset, cooked.Level(i), cooked.Mips()[i].size);
+					offset += cooked.Mips()[i].size;
+				}
+			}
+			else
+				std::memcpy(decode->mapped, decode->pixels, UploadSize(*decode));
+			decode->staged.store(true, std::memory_order_release);
+		});
+	}
+	// Unmaps and deletes a DECODE's PBO, the worker must be done with it. A glTex*Image that read from it
+	// keeps the storage alive in the driver until the GPU has it.
+	static void FreeStaging(DECODE& decoded) {
+		if (decoded.pixelBuffer == 0)
+			return;
+		if (decoded.mapped != nullptr) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, decoded.pixelBuffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			decoded.mapped = nullptr;
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &decoded.pixelBuffer);
+		decoded.pixelBuffer = 0;
+	}
+	// Where each level's texels start: offsets into the PBO, which is left bound and unmapped, or the texels
+	// themselves when there's no PBO or the driver lost its contents
+	static void Levels(DECODE& decoded, const unsigned char* levels[TEXB::MAX_MIPS]) {
+		const TEXB::Texture& cooked = decoded.cooked;
+		if (decoded.pixelBuffer != 0) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, decoded.pixelBuffer);
+			decoded.mapped = nullptr;
+			if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+				FreeStaging(decoded);
+		}
+		const bool fromBuffer = decoded.pixelBuffer != 0;
+		levels[0] = fromBuffer ? nullptr : decoded.pixels;
+		size_t offset = 0;
+		for (unsigned i = 0; cooked.IsOpen() && i < cooked.MipCount(); ++i) {
+			levels[i] = fromBuffer ? reinterpret_cast<const unsigned char*>(offset) : cooked.Level(i);
+			offset += cooked.Mips()[i].size;
+		}
+	}
+	void Upload(TEXTURE& texture) {
+		DECODE& decoded = *texture.decode;
+		const TEXB::Texture& cooked = decoded.cooked;
+		const unsigned char* levels[TEXB::MAX_MIPS];
+		GLuint id = 0;
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D, id);
+		Levels(decoded, levels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of RGB8 aren't always 4 byte multiples
+		if (cooked.IsOpen()) {
+			// the mip chain is baked, nothing to generate
+			for (unsigned i = 0; i < cooked.MipCount(); ++i) {
+				const TEXB::MIP& mip = cooked.Mips()[i];
+				if (cooked.Format() == TEXB::FORMAT_BC1)
+					glCompressedTexImage2D(GL_TEXTURE_2D, i, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, mip.width, mip.height, 0, mip.size, levels[i]);
+				else
+					glTexImage2D(GL_TEXTURE_2D, i, GL_RGB, mip.width, mip.height, 0, GL_RGB, GL_UNSIGNED_BYTE, levels[i]);
+			}
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked.MipCount() - 1);
+		}
+		else {
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, decoded.width, decoded.height, 0, GL_RGB, GL_UNSIGNED_BYTE, levels[0]);
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		FreeStaging(decoded);
+		SetSampling(GL_TEXTURE_2D);
+		texture.id = id;
+		texture.width = cooked.IsOpen() ? cooked.Width() : decoded.width;
+		texture.height = cooked.IsOpen() ? cooked.Height() : decoded.height;
+		texture.ready = true;
+	}
+
+	// Gives every decoded texture that isn't in an array yet a layer in one of its size and format.
+	// Arrays are allocated here with every layer, the layers themselves go up through UploadLayer.
+	void PackArrays() {
+		std::vector<LAYERS*> packed;
+		for (auto& entry : byPath) {
+			TEXTURE& texture = entry.second;
+			if (texture.decode == nullptr || texture.owner != nullptr)
+				continue;
+			const TEXB::Texture& cooked = texture.decode->cooked;
+			unsigned width = cooked.IsOpen() ? cooked.Width() : static_cast<unsigned>(texture.decode->width);
+			unsigned height = cooked.IsOpen() ? cooked.Height() : static_cast<unsigned>(texture.decode->height);
+			unsigned format = cooked.IsOpen() ? cooked.Format() : TEXB::FORMAT_RGB8;
+			LAYERS* layers = nullptr;
+			for (LAYERS* candidate : packed) {
+				if (candidate->width == width && candidate->height == height && candidate->format == format)
+					layers = candidate;
+			}
+			if (layers == nullptr) {
+				layers = &arrays.emplace_back();
+				layers->width = width;
+				layers->height = height;
+				layers->format = format;
+				layers->mipCount = FullMipCount(width, height);
+				packed.push_back(layers);
+			}
+			// BC1 can't have mips generated, the array keeps only the levels every layer has baked
+			if (format == TEXB::FORMAT_BC1)
+				layers->mipCount = std::min(layers->mipCount, cooked.MipCount());
+			else if (cooked.IsOpen() == false || cooked.MipCount() < layers->mipCount)
+				layers->generateMips = true;
+			texture.owner = layers;
+			texture.layer = layers->layerCount++;
+			++layers->waiting;
+			++layers->references;
+		}
+		for (LAYERS* layers : packed) {
+			glGenTextures(1, &layers->id);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, layers->id);
+			unsigned width = layers->width, height = layers->height;
+			for (unsigned i = 0; i < layers->mipCount; ++i) {
+				if (layers->format == TEXB::FORMAT_BC1)
+					glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height, layers->layerCount, 0,
+						TEXB::LevelSize(layers->format, width, height) * layers->layerCount, nullptr);
+				else
+					glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_RGB, width, height, layers->layerCount, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+				width = width > 1 ? width / 2 : 1;
+				height = height > 1 ? height / 2 : 1;
+			}
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, layers->mipCount - 1);
+			SetSampling(GL_TEXTURE_2D_ARRAY);
+		}
+		for (auto& entry : byPath) {
+			if (entry.second.owner != nullptr)
+				entry.second.array = entry.second.owner->id;
+		}
+	}
+	// Same as Upload but into the texture's layer, the array shows once its last layer is in
+	void UploadLayer(TEXTURE& texture) {
+		DECODE& decoded = *texture.decode;
+		const TEXB::Texture& cooked = decoded.cooked;
+		LAYERS& layers = *texture.owner;
+		const unsigned char* levels[TEXB::MAX_MIPS];
+		glBindTexture(GL_TEXTURE_2D_ARRAY, layers.id);
+		Levels(decoded, levels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		unsigned levelCount = cooked.IsOpen() ? std::min(cooked.MipCount(), layers.mipCount) : 1;
+		for (unsigned i = 0; i < levelCount; ++i) {
+			unsigned width = cooked.IsOpen() ? cooked.Mips()[i].width : layers.width;
+			unsigned height = cooked.IsOpen() ? cooked.Mips()[i].height : layers.height;
+			if (layers.format == TEXB::FORMAT_BC1)
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, texture.layer, width, height, 1,
+					GL_COMPRESSED_RGB_S3TC_DXT1_EXT, cooked.Mips()[i].size, levels[i]);
+			else
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, texture.layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, levels[i]);
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		FreeStaging(decoded);
+		texture.width = static_cast<int>(layers.width);
+		texture.height = static_cast<int>(layers.height);
+		if (--layers.waiting == 0)
+			FinishArray(layers);
+	}
+	void FinishArray(LAYERS& layers) {
+		if (layers.generateMips) {
+			glBindTexture(GL_TEXTURE_2D_ARRAY, layers.id);
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		}
+		for (auto& entry : byPath) {
+			if (entry.second.owner == &layers)
+				entry.second.ready = true;
+		}
+	}
+	// a texture's last Release while it sits in an array, the array goes with its last layer
+	void LeaveArray(TEXTURE& texture) {
+		LAYERS& layers = *texture.owner;
+		if (texture.decode != nullptr && --layers.waiting == 0)
+			FinishArray(layers); // its layer was never uploaded, don't keep the others waiting on it
+		if (--layers.references > 0)
+			return;
+		glDeleteTextures(1, &layers.id);
+		for (auto i = arrays.begin(); i != arrays.end(); ++i) {
+			if (&*i == &layers) {
+				arrays.erase(i);
+				break;
+			}
+		}
+	}
+public:
+	TextureCache() {
+		threads.Create(true); // no events, UploadFinished polls instead
+	}
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+	// Deletes whatever is still held, the GL context has to outlive the cache
+	~TextureCache() {
+		for (auto& entry : byPath) {
+			if (entry.second.decode != nullptr && entry.second.decode->stageStarted)
+				orphans.push_back(entry.second.decode);
+		}
+		for (const std::shared_ptr<DECODE>& decode : orphans) {
+			while (decode->staged.load(std::memory_order_acquire) == false)
+				std::this_thread::yield(); // a worker is still copying into the mapping
+			FreeStaging(*decode);
+		}
+		for (auto& entry : byPath) {
+			if (entry.second.owner == nullptr && entry.second.ready)
+				glDeleteTextures(1, &entry.second.id);
+		}
+		for (LAYERS& layers : arrays)
+			glDeleteTextures(1, &layers.id);
+		if (placeholder != 0)
+			glDeleteTextures(1, &placeholder);
+	}
+
+	// Packs textures into array layers from now on, call before the first Acquire.
+	// Only worth it when the shader samples a sampler2DArray, Models drawn through a plain sampler2D need it off.
+	void UseArrays(bool enable) {
+		useArrays = enable && glTexImage3D != nullptr && glTexSubImage3D != nullptr;
+	}
+	bool UsingArrays() const {
+		return useArrays;
+	}
+
+	// Returns the shared texture for texturePath and starts decoding it if it's new. nullptr if there is no such file.
+	// Each successful Acquire needs a matching Release.
+	TEXTURE* Acquire(const char* texturePath) {
+		std::string key = NormalizeAssetPath(texturePath);
+		auto found = byPath.find(key);
+		if (found != byPath.end()) {
+			++found->second.references;
+			return &found->second;
+		}
+		// levels mix back and forward slashes, the key opens on any platform
+		struct stat info;
+		if (stat(key.c_str(), &info) != 0 && stat(CookedPath(key.c_str(), TEXB::EXTENSION).c_str(), &info) != 0)
+			return nullptr; // neither the image nor a .texb cooked from it
+		if (placeholder == 0) {
+			CreatePlaceholder();
+			s3tc = HasOGLExtension("GL_EXT_texture_compression_s3tc");
+		}
+		TEXTURE& texture = byPath[key];
+		texture.id = placeholder;
+		texture.path = key;
+		texture.references = 1;
+		texture.decode = std::make_shared<DECODE>();
+		texture.decode->path = key;
+		texture.decode->allowCompressed = s3tc && (useArrays ?
+			glCompressedTexImage3D != nullptr && glCompressedTexSubImage3D != nullptr : glCompressedTexImage2D != nullptr);
+		std::shared_ptr<DECODE> decode = texture.decode;
+		threads.BranchSingular([decode]() {
+			// a cooked texture only needs mapping, the image is decoded when there isn't a usable one
+			if (decode->cooked.OpenCooked(decode->path.c_str()) &&
+				(decode->cooked.Format() != TEXB::FORMAT_BC1 || decode->allowCompressed) == false)
+				decode->cooked.Close();
+			if (decode->cooked.IsOpen() == false) {
+				int channels;
+				decode->pixels = stbi_load(decode->path.c_str(), &decode->width, &decode->height, &channels, 3);
+			}
+			decode->done.store(true, std::memory_order_release);
+		});
+		return &texture;
+	}
+
+	// Drops one reference, the GL texture is deleted with the last one
+	void Release(TEXTURE* texture) {
+		if (texture == nullptr || --texture->references > 0)
+			return;
+		if (texture->owner != nullptr)
+			LeaveArray(*texture);
+		else if (texture->ready)
+			glDeleteTextures(1, &texture->id);
+		// its PBO can only go once the worker filling it is done, UploadFinished frees it then
+		if (texture->decode != nullptr && texture->decode->stageStarted)
+			orphans.push_back(texture->decode);
+		byPath.erase(texture->path); // a decode still running finishes into its own DECODE and is dropped
+	}
+
+	// Call once a frame. Maps PBOs for finished decodes and uploads the ones workers have filled, each until
+	// byteBudget bytes this frame. The first of each always goes so an image larger than the budget still gets through.
+	void UploadFinished(size_t byteBudget) {
+		for (size_t i = 0; i < orphans.size();) {
+			if (orphans[i]->staged.load(std::memory_order_acquire)) {
+				FreeStaging(*orphans[i]);
+				orphans.erase(orphans.begin() + i);
+			}
+			else
+				++i;
+		}
+		bool decoding = false;
+		for (auto& entry : byPath) {
+			TEXTURE& texture = entry.second;
+			if (texture.decode == nullptr)
+				continue;
+			if (texture.decode->done.load(std::memory_order_acquire) == false)
+				decoding = true;
+			else if (texture.decode->pixels == nullptr && texture.decode->cooked.IsOpen() == false) {
+				std::cerr << "Texture could not be decoded: " << texture.path << std::endl;
+				texture.decode.reset(); // stays on the placeholder
+			}
+		}
+		// arrays are sized by how many images share them, so every size has to be known before packing
+		if (useArrays) {
+			if (decoding)
+				return;
+			PackArrays();
+		}
+		size_t uploaded = 0, staged = 0;
+		for (auto& entry : byPath) {
+			TEXTURE& texture = entry.second;
+			if (texture.decode == nullptr || texture.decode->done.load(std::memory_order_acquire) == false)
+				continue;
+			size_t bytes = UploadSize(*texture.decode);
+			// mapped now, uploaded on a later call once the worker has filled it
+			if (texture.decode->stageStarted == false) {
+				if (staged == 0 || staged + bytes <= byteBudget) {
+					Stage(texture.decode);
+					staged += bytes;
+				}
+				continue;
+			}
+			if (texture.decode->staged.load(std::memory_order_acquire) == false)
+				continue;
+			if (uploaded > 0 && uploaded + bytes > byteBudget)
+				continue; // next frame, something smaller may still fit
+			if (texture.owner != nullptr)
+				UploadLayer(texture);
+			else
+				Upload(texture);
+			texture.decode.reset();
+			uploaded += bytes;
+		}
+	}
+
+	// textures still decoding or waiting for their upload
+	size_t PendingCount() const {
+		size_t total = 0;
+		for (const auto& entry : byPath)
+			total += entry.second.decode != nullptr;
+		return total;
+	}
+	// unique textures held and the Models sharing them, for memory reports
+	size_t TextureCount() const {
+		return byPath.size();
+	}
+	size_t ReferenceCount() const {
+		size_t total = 0;
+		for (const auto& entry : byPath)
+			total += entry.second.references;
+		return total;
+	}
+	// texture arrays the layers were packed into
+	size_t ArrayCount() const {
+		return arrays.size();
+	}
+	// GPU memory held by uploaded textures, counted as RGB8 plus a third again for the mip chain
+	size_t ByteCount() const {
+		size_t total = 0;
+		for (const auto& entry : byPath)
+			total += static_cast<size_t>(entry.second.width) * entry.second.height * 3 * 4 / 3;
+		return total;
+	}
+};
@@ -0,0 +1,217 @@
+// Offline tool that cooks .jpg/.png textures into the .texb format the game uploads without decoding.
+// usage: TextureCooker [--bc1] Textures/Stone.jpg [Textures/Gold.jpg ...]
+// Each .texb is written next to the image it came from, --bc1 stores DXT1 blocks instead of RGB8 (1/6 the size).
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "TextureBinary.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// one RGB8 level while the chain is being built
+struct Image {
+	unsigned width = 0, height = 0;
+	std::vector<unsigned char> texels;
+	const unsigned char* Texel(unsigned x, unsigned y) const {
+		return &texels[(std::min(y, height - 1) * width + std::min(x, width - 1)) * 3];
+	}
+};
+
+// Next mip down, a 2x2 box filter like glGenerateMipmap. An odd last row or column is dropped,
+// only an edge that is already 1 texel wide is repeated to fill the box.
+Image Downsample(const Image& source) {
+	Image out;
+	out.width = std::max(1u, source.width / 2);
+	out.height = std::max(1u, source.height / 2);
+	out.texels.resize(static_cast<size_t>(out.width) * out.height * 3);
+	for (unsigned y = 0; y < out.height; ++y) {
+		for (unsigned x = 0; x < out.width; ++x) {
+			for (int c = 0; c < 3; ++c) {
+				unsigned sum = source.Texel(x * 2, y * 2)[c] + source.Texel(x * 2 + 1, y * 2)[c] +
+					source.Texel(x * 2, y * 2 + 1)[c] + source.Texel(x * 2 + 1, y * 2 + 1)[c];
+				out.texels[(static_cast<size_t>(y) * out.width + x) * 3 + c] = static_cast<unsigned char>((sum + 2) / 4);
+			}
+		}
+	}
+	return out;
+}
+
+unsigned short To565(const float rgb[3]) {
+	unsigned r = static_cast<unsigned>(std::clamp(rgb[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	unsigned g = static_cast<unsigned>(std::clamp(rgb[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+	unsigned b = static_cast<unsigned>(std::clamp(rgb[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	return static_cast<unsigned short>((r << 11) | (g << 5) | b);
+}
+void From565(unsigned short color, float rgb[3]) {
+	rgb[0] = static_cast<float>((color >> 11) & 31) * 255.0f / 31.0f;
+	rgb[1] = static_cast<float>((color >> 5) & 63) * 255.0f / 63.0f;
+	rgb[2] = static_cast<float>(color & 31) * 255.0f / 31.0f;
+}
+
+// One 4x4 block as DXT1. Endpoints are the block's bounding box corners along its main diagonal,
+// pulled in a little so the extremes don't swallow the two in-between colors.
+void CompressBlock(const Image& image, unsigned blockX, unsigned blockY, unsigned char out[8]) {
+	float texels[16][3];
+	float low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+	for (unsigned i = 0; i < 16; ++i) {
+		const unsigned char* texel = image.Texel(blockX * 4 + i % 4, blockY * 4 + i / 4);
+		for (int c = 0; c < 3; ++c) {
+			texels[i][c] = texel[c];
+			low[c] = std::min(low[c], texels[i][c]);
+			high[c] = std::max(high[c], texels[i][c]);
+		}
+	}
+	// the box diagonal runs min to max on every axis unless the colors trend the other way on some
+	float center[3], covariance[3] = { 0, 0, 0 };
+	for (int c = 0; c < 3; ++c)
+		center[c] = (low[c] + high[c]) * 0.5f;
+	for (unsigned i = 0; i < 16; ++i) {
+		covariance[1] += (texels[i][0] - center[0]) * (texels[i][1] - center[1]);
+		covariance[2] += (texels[i][0] - center[0]) * (texels[i][2] - center[2]);
+	}
+	if (covariance[1] < 0)
+		std::swap(low[1], high[1]);
+	if (covariance[2] < 0)
+		std::swap(low[2], high[2]);
+	for (int c = 0; c < 3; ++c) {
+		float inset = (high[c] - low[c]) / 16.0f;
+		low[c] += inset;
+		high[c] -= inset;
+	}
+	unsigned short color0 = To565(high), color1 = To565(low);
+	if (color0 < color1)
+		std::swap(color0, color1); // color0 > color1 picks the 4 color mode
+	float palette[4][3];
+	From565(color0, palette[0]);
+	From565(color1, palette[1]);
+	for (int c = 0; c < 3; ++c) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+	unsigned indices = 0;
+	for (unsigned i = 0; i < 16 && color0 != color1; ++i) {
+		unsigned best = 0;
+		float bestDistance = 1e30f;
+		for (unsigned p = 0; p < 4; ++p) {
+			float distance = 0;
+			for (int c = 0; c < 3; ++c)
+				distance += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				best = p;
+			}
+		}
+		indices |= best << (i * 2);
+	}
+	std::memcpy(out, &color0, 2);
+	std::memcpy(out + 2, &color1, 2);
+	std::memcpy(out + 4, &indices, 4);
+}
+
+// the bytes a level is stored as in the given format
+std::vector<unsigned char> EncodeLevel(const Image& image, unsigned format) {
+	if (format == TEXB::FORMAT_RGB8)
+		return image.texels;
+	std::vector<unsigned char> blocks(TEXB::LevelSize(format, image.width, image.height));
+	unsigned blocksWide = (image.width + 3) / 4, blocksHigh = (image.height + 3) / 4;
+	for (unsigned y = 0; y < blocksHigh; ++y)
+		for (unsigned x = 0; x < blocksWide; ++x)
+			CompressBlock(image, x, y, &blocks[(static_cast<size_t>(y) * blocksWide + x) * 8]);
+	return blocks;
+}
+
+unsigned AlignLevel(unsigned offset) {
+	return (offset + TEXB::LEVEL_ALIGNMENT - 1) / TEXB::LEVEL_ALIGNMENT * TEXB::LEVEL_ALIGNMENT;
+}
+
+// Cooks one image, false if it can't be read or written
+bool CookTexture(const char* imagePath, unsigned format) {
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(imagePath, &width, &height, &channels, 3);
+	if (pixels == nullptr) {
+		std::cerr << "Not a readable image: " << imagePath << std::endl;
+		return false;
+	}
+	Image level;
+	level.width = static_cast<unsigned>(width);
+	level.height = static_cast<unsigned>(height);
+	level.texels.assign(pixels, pixels + static_cast<size_t>(width) * height * 3);
+	stbi_image_free(pixels);
+
+	// every level down to 1x1, the same chain glGenerateMipmap would have made at load
+	std::vector<std::vector<unsigned char>> levels;
+	std::vector<TEXB::MIP> mips;
+	while (true) {
+		levels.push_back(EncodeLevel(level, format));
+		mips.push_back({ 0, static_cast<unsigned>(levels.back().size()), level.width, level.height });
+		if ((level.width == 1 && level.height == 1) || mips.size() == TEXB::MAX_MIPS)
+			break;
+		level = Downsample(level);
+	}
+	TEXB::HEADER header = {};
+	std::memcpy(header.magic, TEXB::MAGIC, 4);
+	header.version = TEXB::VERSION;
+	header.format = format;
+	header.width = static_cast<unsigned>(width);
+	header.height = static_cast<unsigned>(height);
+	header.mipCount = static_cast<unsigned>(mips.size());
+	unsigned offset = AlignLevel(sizeof(TEXB::HEADER) + sizeof(TEXB::MIP) * header.mipCount);
+	for (TEXB::MIP& mip : mips) {
+		mip.offset = offset;
+		offset = AlignLevel(offset + mip.size);
+	}
+	header.fileSize = mips.back().offset + mips.back().size;
+
+	// lay the whole file out in memory so it goes to disk in one write
+	std::vector<char> image(header.fileSize, 0);
+	std::memcpy(image.data(), &header, sizeof(header));
+	std::memcpy(image.data() + sizeof(header), mips.data(), mips.size() * sizeof(TEXB::MIP));
+	for (size_t i = 0; i < mips.size(); ++i)
+		std::memcpy(image.data() + mips[i].offset, levels[i].data(), levels[i].size());
+	std::string texbPath = CookedPath(imagePath, TEXB::EXTENSION);
+	std::ofstream file(texbPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (file.is_open() == false) {
+		std::cerr << "Unable to write: " << texbPath << std::endl;
+		return false;
+	}
+	file.write(image.data(), image.size());
+	if (file.good() == false) {
+		std::cerr << "Unable to write: " << texbPath << std::endl;
+		return false;
+	}
+	file.close();
+
+	// a header or level table that doesn't map cleanly fails the cook rather than falling back at runtime
+	TEXB::Texture check;
+	if (check.Open(texbPath.c_str()) == false) {
+		std::cerr << "Cooked texture failed validation: " << texbPath << std::endl;
+		return false;
+	}
+	std::cout << "Cooked " << imagePath << " -> " << texbPath << " (" << width << "x" << height << ", "
+		<< check.MipCount() << " mips, " << (format == TEXB::FORMAT_BC1 ? "BC1" : "RGB8") << ", "
+		<< header.fileSize << " bytes)" << std::endl;
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	unsigned format = TEXB::FORMAT_RGB8;
+	int first = 1;
+	if (argc > 1 && std::string(argv[1]) == "--bc1") {
+		format = TEXB::FORMAT_BC1;
+		first = 2;
+	}
+	if (argc <= first) {
+		std::cerr << "usage: TextureCooker [--bc1] Texture.jpg [Texture2.png ...]" << std::endl;
+		return 1;
+	}
+	int failures = 0;
+	for (int i = first; i < argc; ++i) {
+		if (CookTexture(argv[i], format) == false)
+			++failures;
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -28,3 +28,4 @@ struct Power
 };
 
 // Individual TAGs
+struct Dynamic {}; // moves or gets destroyed, the renderer keeps it out of the cached static layer
@@ -79,6 +79,8 @@ public:
             else if (modelName == "Ruby" || modelName == "Moonstone") { ent.set<Health>({ 3 }); }
             else if (modelName == "Ball") { ent.set<Damage>({ 1 }); }
             else if (modelName == "Player") { ent.set<Lives>({ 4 }); }
+            // bricks, the ball and the paddle are all that move or disappear, everything else is scenery
+            if (ent.has<Health>() || ent.has<Damage>() || ent.has<Lives>()) { ent.add<Dynamic>(); }
         }
 
 
@@ -211,17 +213,10 @@ public:
     //}
 
     bool kbm = false;
+    // Called once per paced frame, the FramePacer in main.cpp holds the loop at the target frame rate
     void Update(Level_Data& level, GW::SYSTEM::GLog& log, GW::INPUT::GInput& input, float dt) {
-        // Cap the frame rate
-        static auto lastFrameTime = std::chrono::high_resolution_clock::now();
-        auto currentFrameTime = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<float> elapsed = currentFrameTime - lastFrameTime;
         /*setUpScoreOverlay();
         setUpLivesOverlay();*/
-        if (elapsed.count() < 1.0f / 60.0f) {
-            return; // Return early if frame time is too short
-        }
-        lastFrameTime = currentFrameTime;
 
         float kbm_states[256];
         memset(kbm_states, 0, sizeof(kbm_states));
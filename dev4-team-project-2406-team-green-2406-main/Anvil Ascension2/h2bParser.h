@@ -3,6 +3,10 @@
 #include <fstream>
 #include <vector>
 #include <set>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include "MappedFile.h"
 
 namespace H2B {
 
@@ -45,13 +49,14 @@ namespace H2B {
 	};
 	class Parser
 	{
+		friend class MappedParser; // materializes into a Parser
 		std::set<std::string> file_strings;
 	public:
-		char version[4];
-		unsigned vertexCount;
-		unsigned indexCount;
-		unsigned materialCount;
-		unsigned meshCount;
+		char version[4] = {};
+		unsigned vertexCount = 0;
+		unsigned indexCount = 0;
+		unsigned materialCount = 0;
+		unsigned meshCount = 0;
 		std::vector<VERTEX> vertices;
 		std::vector<unsigned> indices;
 		std::vector<MATERIAL> materials;
@@ -108,7 +113,7 @@ namespace H2B {
 		}
 		void Clear()
 		{
-			*reinterpret_cast<unsigned*>(version) = 0;
+			std::memset(version, 0, sizeof(version));
 			file_strings.clear();
 			vertices.clear();
 			indices.clear();
@@ -117,5 +122,333 @@ namespace H2B {
 			meshes.clear();
 		}
 	};
+
+	// .h2b2 files are .h2b files cooked by ModelCooker, vertices shrink from 36 to 16 bytes
+	// and indices are 16 bit whenever the model has few enough vertices
+	constexpr char PACKED_MAGIC[4] = { 'H', '2', 'B', '2' };
+#pragma pack(push,1)
+	struct PACKED_VERTEX {
+		short pos[4]; // snorm16 position inside the model bounds (center + extent * pos), w unused
+		unsigned short uv[2]; // half floats
+		unsigned nrm; // snorm 2_10_10_10 normal, multiplied by the bounds extent so the bounds scale can be undone with the world matrix
+	};
+#pragma pack(pop)
+	static_assert(sizeof(PACKED_VERTEX) == 16, "PACKED_VERTEX must stay 16 bytes");
+
+	inline unsigned short FloatToHalf(float value) {
+		unsigned bits;
+		std::memcpy(&bits, &value, 4);
+		unsigned sign = (bits >> 16) & 0x8000;
+		int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+		unsigned mantissa = bits & 0x7FFFFF;
+		if (exponent <= 0) { // too small for a normal half, flush to a denormal or zero
+			if (exponent < -10)
+				return static_cast<unsigned short>(sign);
+			mantissa |= 0x800000;
+			unsigned shift = static_cast<unsigned>(14 - exponent);
+			unsigned half = mantissa >> shift;
+			if ((mantissa >> (shift - 1)) & 1) // round to nearest
+				++half;
+			return static_cast<unsigned short>(sign | half);
+		}
+		if (exponent >= 31) // too big (or inf/nan), clamp to infinity
+			return static_cast<unsigned short>(sign | 0x7C00);
+		unsigned half = sign | (static_cast<unsigned>(exponent) << 10) | (mantissa >> 13);
+		if (mantissa & 0x1000) // round to nearest, a carry into the exponent is still correct
+			++half;
+		return static_cast<unsigned short>(half);
+	}
+	inline float HalfToFloat(unsigned short half) {
+		unsigned sign = (half & 0x8000u) << 16;
+		unsigned exponent = (half >> 10) & 0x1F;
+		unsigned mantissa = half & 0x3FF;
+		float value;
+		if (exponent == 0)
+			value = std::ldexp(static_cast<float>(mantissa), -24);
+		else if (exponent == 31)
+			value = mantissa ? NAN : INFINITY;
+		else
+			value = std::ldexp(static_cast<float>(mantissa | 0x400), static_cast<int>(exponent) - 25);
+		unsigned bits;
+		std::memcpy(&bits, &value, 4);
+		bits |= sign;
+		std::memcpy(&value, &bits, 4);
+		return value;
+	}
+	inline short FloatToSnorm16(float value) {
+		value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return static_cast<short>(std::lround(value * 32767.0f));
+	}
+	// xyz packed as signed 10 bit normalized values, the GL_INT_2_10_10_10_REV layout
+	inline unsigned PackSnorm10x3(float x, float y, float z) {
+		auto pack = [](float value) {
+			value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+			return static_cast<unsigned>(std::lround(value * 511.0f)) & 0x3FF;
+		};
+		return pack(x) | (pack(y) << 10) | (pack(z) << 20);
+	}
+	inline void UnpackSnorm10x3(unsigned packed, float out[3]) {
+		for (int i = 0; i < 3; ++i) {
+			int value = static_cast<int>((packed >> (i * 10)) & 0x3FF);
+			if (value & 0x200)
+				value -= 0x400; // sign extend
+			out[i] = value < -511 ? -1.0f : value / 511.0f;
+		}
+	}
+	// The center and half size of the box around vertices, what PackVertex stores positions relative to.
+	// Flat axes get an extent of 1 so there's still something to divide by.
+	inline void MeasureBounds(const VERTEX* vertices, size_t count, float center[3], float extent[3]) {
+		float minimum[3] = { 0, 0, 0 }, maximum[3] = { 0, 0, 0 };
+		for (size_t i = 0; i < count; ++i) {
+			const float* pos = &vertices[i].pos.x;
+			for (int axis = 0; axis < 3; ++axis) {
+				if (i == 0 || pos[axis] < minimum[axis])
+					minimum[axis] = pos[axis];
+				if (i == 0 || pos[axis] > maximum[axis])
+					maximum[axis] = pos[axis];
+			}
+		}
+		for (int axis = 0; axis < 3; ++axis) {
+			center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+			extent[axis] = (maximum[axis] - minimum[axis]) * 0.5f;
+			if (extent[axis] <= 0)
+				extent[axis] = 1.0f;
+		}
+	}
+	// center/extent describe the model bounds, extent must not have zeros
+	inline PACKED_VERTEX PackVertex(const VERTEX& vertex, const float center[3], const float extent[3]) {
+		PACKED_VERTEX out = {};
+		out.pos[0] = FloatToSnorm16((vertex.pos.x - center[0]) / extent[0]);
+		out.pos[1] = FloatToSnorm16((vertex.pos.y - center[1]) / extent[1]);
+		out.pos[2] = FloatToSnorm16((vertex.pos.z - center[2]) / extent[2]);
+		out.uv[0] = FloatToHalf(vertex.uvw.x);
+		out.uv[1] = FloatToHalf(vertex.uvw.y);
+		// the bounds scale is folded into the world matrix, scaling the normal by it here cancels
+		// the inverse scale the shader's inverse transpose applies
+		float n[3] = { vertex.nrm.x * extent[0], vertex.nrm.y * extent[1], vertex.nrm.z * extent[2] };
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length > 0)
+			out.nrm = PackSnorm10x3(n[0] / length, n[1] / length, n[2] / length);
+		return out;
+	}
+	inline VERTEX UnpackVertex(const PACKED_VERTEX& packed, const float center[3], const float extent[3]) {
+		VERTEX out = {};
+		out.pos.x = center[0] + extent[0] * (packed.pos[0] < -32767 ? -1.0f : packed.pos[0] / 32767.0f);
+		out.pos.y = center[1] + extent[1] * (packed.pos[1] < -32767 ? -1.0f : packed.pos[1] / 32767.0f);
+		out.pos.z = center[2] + extent[2] * (packed.pos[2] < -32767 ? -1.0f : packed.pos[2] / 32767.0f);
+		out.uvw.x = HalfToFloat(packed.uv[0]);
+		out.uvw.y = HalfToFloat(packed.uv[1]);
+		float n[3];
+		UnpackSnorm10x3(packed.nrm, n);
+		n[0] /= extent[0];
+		n[1] /= extent[1];
+		n[2] /= extent[2];
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length > 0)
+			out.nrm = { n[0] / length, n[1] / length, n[2] / length };
+		return out;
+	}
+
+	// read only array that lives inside a MappedParser's file
+	template<typename T>
+	struct SPAN {
+		const T* data = nullptr;
+		unsigned count = 0;
+		const T* begin() const { return data; }
+		const T* end() const { return data + count; }
+		unsigned size() const { return count; }
+		const T& operator[](unsigned i) const { return data[i]; }
+	};
+	// MATERIAL with the names left in the file
+	struct MATERIAL_VIEW {
+		ATTRIBUTES attrib;
+		std::string_view names[10]; // name, map_Kd ... bump in MATERIAL order, empty if unused
+	};
+	// MESH with the name left in the file
+	struct MESH_VIEW {
+		std::string_view name;
+		BATCH drawInfo;
+		unsigned materialIndex;
+	};
+	// Parses a memory mapped .h2b or .h2b2 without copying it, vertex/index/batch data are spans into the file.
+	// Everything stays valid until the next Parse or Clear, Materialize() when the data has to outlive that.
+	class MappedParser
+	{
+		MappedFile file;
+		const unsigned char* next = nullptr; // read cursor
+		const unsigned char* end = nullptr;
+
+		bool ReadBytes(void* out, size_t bytes) {
+			if (static_cast<size_t>(end - next) < bytes)
+				return false;
+			std::memcpy(out, next, bytes);
+			next += bytes;
+			return true;
+		}
+		template<typename T>
+		bool ReadSpan(SPAN<T>& out, unsigned count) {
+			if (static_cast<size_t>(end - next) / sizeof(T) < count)
+				return false;
+			out.data = reinterpret_cast<const T*>(next);
+			out.count = count;
+			next += sizeof(T) * static_cast<size_t>(count);
+			return true;
+		}
+		bool Skip(size_t bytes) {
+			if (static_cast<size_t>(end - next) < bytes)
+				return false;
+			next += bytes;
+			return true;
+		}
+		bool ReadString(std::string_view& out) {
+			const void* terminator = std::memchr(next, '\0', end - next);
+			if (terminator == nullptr)
+				return false;
+			out = std::string_view(reinterpret_cast<const char*>(next),
+				static_cast<const unsigned char*>(terminator) - next);
+			next = static_cast<const unsigned char*>(terminator) + 1;
+			return true;
+		}
+	public:
+		char version[4] = {};
+		unsigned vertexCount = 0;
+		unsigned indexCount = 0;
+		unsigned materialCount = 0;
+		unsigned meshCount = 0;
+		unsigned indexSize = 4; // 2 or 4 bytes
+		SPAN<VERTEX> vertices; // .h2b only
+		SPAN<unsigned> indices; // when indexSize is 4
+		SPAN<PACKED_VERTEX> packedVertices; // .h2b2 only
+		SPAN<unsigned short> shortIndices; // when indexSize is 2
+		float boundsCenter[3] = {}; // .h2b2 only, packed positions are relative to these
+		float boundsExtent[3] = {};
+		SPAN<BATCH> batches;
+		std::vector<MATERIAL_VIEW> materials; // small, copied out since ATTRIBUTES aren't aligned in the file
+		std::vector<MESH_VIEW> meshes; // same
+		bool Parse(const char* h2bPath)
+		{
+			Clear();
+			if (file.Open(h2bPath) == false)
+				return false;
+			next = file.Data();
+			end = next + file.Size();
+			bool valid = ReadBytes(version, 4);
+			bool packed = valid && std::memcmp(version, PACKED_MAGIC, 4) == 0;
+			if (valid == false || (packed == false &&
+				(version[1] < '1' || version[2] < '9' || version[3] < 'd'))) {
+				Clear();
+				return false;
+			}
+			valid = ReadBytes(&vertexCount, 4) && ReadBytes(&indexCount, 4) &&
+				ReadBytes(&materialCount, 4) && ReadBytes(&meshCount, 4);
+			if (packed) {
+				valid = valid && ReadBytes(&indexSize, 4) &&
+					ReadBytes(boundsCenter, 12) && ReadBytes(boundsExtent, 12) &&
+					ReadSpan(packedVertices, vertexCount);
+				if (indexSize == 2) // padded so what follows stays 4 byte aligned
+					valid = valid && ReadSpan(shortIndices, indexCount) && Skip((indexCount & 1) * 2);
+				else
+					valid = valid && indexSize == 4 && ReadSpan(indices, indexCount);
+			}
+			else
+				valid = valid && ReadSpan(vertices, vertexCount) && ReadSpan(indices, indexCount);
+			if (valid)
+				materials.resize(materialCount);
+			for (unsigned i = 0; valid && i < materialCount; ++i) {
+				valid = ReadBytes(&materials[i].attrib, 80);
+				for (int j = 0; valid && j < 10; ++j)
+					valid = ReadString(materials[i].names[j]);
+			}
+			valid = valid && ReadSpan(batches, materialCount);
+			if (valid)
+				meshes.resize(meshCount);
+			for (unsigned i = 0; valid && i < meshCount; ++i) {
+				valid = ReadString(meshes[i].name) && ReadBytes(&meshes[i].drawInfo, 8) &&
+					ReadBytes(&meshes[i].materialIndex, 4);
+			}
+			if (valid == false)
+				Clear(); // truncated file
+			return valid;
+		}
+		// Parses the .h2b2 ModelCooker wrote next to h2bPath unless the .h2b was exported after it, else the .h2b
+		bool ParseNewest(const std::string& h2bPath)
+		{
+			std::string packedPath = h2bPath + "2";
+			return (IsCookedFileCurrent(packedPath.c_str(), h2bPath.c_str()) && Parse(packedPath.c_str())) ||
+				Parse(h2bPath.c_str());
+		}
+		bool IsPacked() const
+		{
+			return std::memcmp(version, PACKED_MAGIC, 4) == 0;
+		}
+		// start of the index data, indexSize bytes each
+		const void* IndexData() const
+		{
+			return indexSize == 2 ? static_cast<const void*>(shortIndices.data) : indices.data;
+		}
+		// the mapped file every span points into
+		const MappedFile& File() const
+		{
+			return file;
+		}
+		// Copies everything into a regular Parser, names included, packed data is expanded back to floats
+		void Materialize(Parser& out) const
+		{
+			out.Clear();
+			std::memcpy(out.version, version, 4);
+			out.vertexCount = vertexCount;
+			out.indexCount = indexCount;
+			out.materialCount = materialCount;
+			out.meshCount = meshCount;
+			if (IsPacked()) {
+				out.vertices.resize(vertexCount);
+				for (unsigned i = 0; i < vertexCount; ++i)
+					out.vertices[i] = UnpackVertex(packedVertices[i], boundsCenter, boundsExtent);
+			}
+			else
+				out.vertices.assign(vertices.begin(), vertices.end());
+			if (indexSize == 2)
+				out.indices.assign(shortIndices.begin(), shortIndices.end());
+			else
+				out.indices.assign(indices.begin(), indices.end());
+			out.batches.assign(batches.begin(), batches.end());
+			out.materials.resize(materialCount);
+			for (unsigned i = 0; i < materialCount; ++i) {
+				out.materials[i] = {};
+				out.materials[i].attrib = materials[i].attrib;
+				// the material's own name is always a string, even an empty one, unused maps stay nullptr
+				for (int j = 0; j < 10; ++j) {
+					if (j == 0 || materials[i].names[j].empty() == false)
+						*((&out.materials[i].name) + j) =
+						out.file_strings.emplace(materials[i].names[j]).first->c_str();
+				}
+			}
+			out.meshes.resize(meshCount);
+			for (unsigned i = 0; i < meshCount; ++i) {
+				out.meshes[i].name = meshes[i].name.empty() ? nullptr :
+					out.file_strings.emplace(meshes[i].name).first->c_str();
+				out.meshes[i].drawInfo = meshes[i].drawInfo;
+				out.meshes[i].materialIndex = meshes[i].materialIndex;
+			}
+		}
+		// Unmaps the file, every span and view is invalid after this
+		void Clear()
+		{
+			file.Close();
+			next = end = nullptr;
+			std::memset(version, 0, sizeof(version));
+			vertexCount = indexCount = materialCount = meshCount = 0;
+			indexSize = 4;
+			vertices = {};
+			indices = {};
+			packedVertices = {};
+			shortIndices = {};
+			std::memset(boundsCenter, 0, sizeof(boundsCenter));
+			std::memset(boundsExtent, 0, sizeof(boundsExtent));
+			batches = {};
+			materials.clear();
+			meshes.clear();
+		}
+	};
 }
 #endif
\ No newline at end of file
@@ -6,12 +6,19 @@
 
 // This reads .h2b files which are optimized binary .obj+.mtl files
 #include "h2bParser.h"
+// Cooked .lvlb levels are memory mapped instead of parsed when they're up to date
+#include "LevelBinary.h"
+// Reads GameLevel*.txt when there is no cooked level
+#include "LevelTextParser.h"
+#include <unordered_map>
 
 class Level_Data {
 
 	// transfered from parser
 	std::set<std::string> level_strings;
 	std::vector<std::string> levelTextureFiles;
+	// text is read through here, its buffer is reused by every load
+	LevelText::Parser levelText;
 public:
 	struct LEVEL_MODEL // one model in the level
 	{
@@ -21,6 +28,8 @@ public:
 		unsigned vertexStart, indexStart, materialStart, meshStart, batchStart;
 		unsigned colliderIndex; // *NEW* location of OBB in levelColliders
 		std::string textureFilePath;
+		// its levelVertices positions are -1 to 1 inside these bounds, the world matrix scales them back out
+		float boundsCenter[3], boundsExtent[3];
 
 	};
 	struct MODEL_INSTANCES // each instance of a model in the level
@@ -36,8 +45,8 @@ public:
 		const char* blendername; // *NEW* name of model straight from blender (FLECS)
 		unsigned int modelIndex, transformIndex;
 	};
-	// All geometry data combined for level to be loaded onto the video card
-	std::vector<H2B::VERTEX> levelVertices;
+	// All geometry data combined for level to be loaded onto the video card, in the 16 byte .h2b2 layout
+	std::vector<H2B::PACKED_VERTEX> levelVertices;
 	std::vector<unsigned> levelIndices;
 	// All material data used by the level
 	std::vector<H2B::MATERIAL> levelMaterials;
@@ -62,10 +71,14 @@ public:
 
 		UnloadLevel(); // clear previous level data if there is any
 		std::vector<MODEL_ENTRY> uniqueModels; // unique models and their locations
-		if (ReadGameLevel(gameLevelPath, uniqueModels, log) == false) {
+		LVLB::Level cooked;
+		if (cooked.OpenCooked(gameLevelPath))
+			ReadCookedLevel(cooked, uniqueModels, log);
+		else if (ReadGameLevel(gameLevelPath, uniqueModels, log) == false) {
 			log.LogCategorized("ERROR", "Fatal error reading game level, aborting level load.");
 			return false;
 		}
+		MergeInstances(uniqueModels);
 		if (ReadAndCombineH2Bs(h2bFolderPath, uniqueModels, log) == false) {
 			log.LogCategorized("ERROR", "Fatal error combining H2B mesh data, aborting level load.");
 			return false;
@@ -122,95 +135,140 @@ private:
 			return out;
 		}
 	};
+	// Entries that use the same .h2b and texture become one model with an instance each,
+	// so every brick of a kind is imported once and can be drawn in a single instanced call.
+	// First appearance order is kept so levels still import the same way every load.
+	static void MergeInstances(std::vector<MODEL_ENTRY>& models) {
+		std::unordered_map<std::string, size_t> firstEntry;
+		size_t kept = 0;
+		for (size_t i = 0; i < models.size(); ++i) {
+			auto added = firstEntry.emplace(models[i].modelFile + '|' + models[i].textureFilePath, kept);
+			if (added.second) {
+				if (kept != i)
+					models[kept] = std::move(models[i]);
+				++kept;
+				continue;
+			}
+			const MODEL_ENTRY& into = models[added.first->second];
+			into.blenderNames.insert(into.blenderNames.end(), models[i].blenderNames.begin(), models[i].blenderNames.end());
+			into.instances.insert(into.instances.end(), models[i].instances.begin(), models[i].instances.end());
+		}
+		models.resize(kept);
+	}
 	// internal helper for reading the game level
 	bool ReadGameLevel(const char* gameLevelPath, std::vector<MODEL_ENTRY>& outModels, GW::SYSTEM::GLog log) {
 		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
-		GW::SYSTEM::GFile file;
-		file.Create();
-		if (-file.OpenTextRead(gameLevelPath)) {
+		if (levelText.Load(gameLevelPath) == false) {
 			log.LogCategorized("ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
 			return false;
 		}
-		char linebuffer[1024];
-		while (+file.ReadLine(linebuffer, 1024, '\n')) {
-			if (linebuffer[0] == '\0')
-				break;
-			if (std::strcmp(linebuffer, "MESH") == 0) {
-				file.ReadLine(linebuffer, 1024, '\n');
-				std::string blenderName = linebuffer;
-
-				MODEL_ENTRY add = { linebuffer };
-				add.modelFile = add.modelFile.substr(0, add.modelFile.find_last_of("."));
-				add.modelFile += ".h2b";
-
-				// now read the transform data as we will need that regardless
-				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
-						&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-						&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-
-				// read the texture file path
-				std::string textureFilePath;
-				file.ReadLine(linebuffer, 1024, '\n');
-				if (std::strcmp(linebuffer, "TEXTURE") == 0)
-				{
-					// read the texture file path
-					file.ReadLine(linebuffer, 1024, '\n');
-					textureFilePath = linebuffer;
-				}
-
-				for (int i = 0; i < 8; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					// read floats
-					std::sscanf(linebuffer + 9, "%f, %f, %f",
-						&add.boundry[i].x, &add.boundry[i].y, &add.boundry[i].z);
-				}
-				std::string bounds = "Boundry: Left ";
-				bounds += std::to_string(add.boundry[0].x) +
-					" Right " + std::to_string(add.boundry[6].x) +
-					" Bottom " + std::to_string(add.boundry[0].y) +
-					" Top " + std::to_string(add.boundry[6].y) +
-					" Near " + std::to_string(add.boundry[0].z) +
-					" Far " + std::to_string(add.boundry[6].z);
-
-				// does this model already exist?
-
-				add.blenderNames.push_back(blenderName);
-				add.instances.push_back(transform);
-				add.textureFilePath = textureFilePath; // store the texture file path
-				outModels.push_back(add);
-
-			}
-		}
+		levelText.Parse([&outModels](const LevelText::MESH& mesh) {
+			MODEL_ENTRY add;
+			add.modelFile.assign(mesh.ModelName().data(), mesh.ModelName().size()).append(".h2b");
+			add.textureFilePath.assign(mesh.texturePath.data(), mesh.texturePath.size());
+			std::memcpy(add.boundry, mesh.bounds, sizeof(add.boundry));
+			GW::MATH::GMATRIXF transform;
+			std::memcpy(transform.data, mesh.transform, sizeof(transform.data));
+			add.blenderNames.emplace_back(mesh.blenderName.data(), mesh.blenderName.size());
+			add.instances.push_back(transform);
+			outModels.push_back(std::move(add));
+		}, [](const LevelText::LIGHT&) {});
 		return true;
 	}
+	// internal helper for reading a cooked game level, the same entries ReadGameLevel makes without any parsing
+	void ReadCookedLevel(const LVLB::Level& cooked, std::vector<MODEL_ENTRY>& outModels, GW::SYSTEM::GLog log) {
+		static_assert(sizeof(LVLB::MATRIX) == sizeof(GW::MATH::GMATRIXF), "cooked transforms must match GMATRIXF");
+		static_assert(sizeof(LVLB::BOUNDS) == sizeof(MODEL_ENTRY::boundry), "cooked bounds must match GVECTOR3F[8]");
+		log.LogCategorized("MESSAGE", "Reading Cooked Game Level.");
+		outModels.reserve(cooked.ObjectCount());
+		for (unsigned i = 0; i < cooked.ObjectCount(); ++i) {
+			const LVLB::OBJECT& object = cooked.Objects()[i];
+			MODEL_ENTRY add = { cooked.String(object.modelFile) };
+			if (object.texturePath != LVLB::NO_STRING)
+				add.textureFilePath = cooked.String(object.texturePath);
+			std::memcpy(add.boundry, &cooked.Bounds()[i], sizeof(add.boundry));
+			GW::MATH::GMATRIXF transform;
+			std::memcpy(&transform, &cooked.Transforms()[i], sizeof(transform));
+			add.blenderNames.push_back(cooked.String(object.blenderName));
+			add.instances.push_back(transform);
+			outModels.push_back(std::move(add));
+		}
+	}
+	// one model's private import result, each is filled by a single worker thread
+	struct MODEL_IMPORT
+	{
+		H2B::MappedParser parser; // maps the .h2b or .h2b2, data is only copied once into the level arrays
+		bool found = false;
+		float boundsCenter[3] = {}, boundsExtent[3] = {}; // what its vertices are packed against
+		unsigned vertexStart = 0, indexStart = 0, batchStart = 0; // where it lands in the level arrays
+	};
+	// where the copy jobs write, sized before any of them start
+	struct IMPORT_TARGET
+	{
+		H2B::PACKED_VERTEX* vertices;
+		unsigned* indices;
+		H2B::BATCH* batches;
+	};
+	// GConcurrent job, maps and validates one model, the cooked .h2b2 when it's current (userData is the model folder)
+	static void ParseModelJob(const MODEL_ENTRY* entry, MODEL_IMPORT* out, unsigned int, const void* userData) {
+		const std::string& modelPath = *static_cast<const std::string*>(userData);
+		out->found = out->parser.ParseNewest(modelPath + "/" + entry->modelFile);
+		if (out->found == false)
+			return;
+		const H2B::MappedParser& p = out->parser;
+		if (p.IsPacked()) {
+			std::memcpy(out->boundsCenter, p.boundsCenter, sizeof(out->boundsCenter));
+			std::memcpy(out->boundsExtent, p.boundsExtent, sizeof(out->boundsExtent));
+		}
+		else
+			H2B::MeasureBounds(p.vertices.data, p.vertexCount, out->boundsCenter, out->boundsExtent);
+	}
+	// GConcurrent job, copies one parsed model into its slice of the level arrays (userData is the IMPORT_TARGET)
+	static void CopyModelJob(const MODEL_ENTRY*, MODEL_IMPORT* in, unsigned int, const void* userData) {
+		if (in->found == false)
+			return;
+		const IMPORT_TARGET& target = *static_cast<const IMPORT_TARGET*>(userData);
+		const H2B::MappedParser& p = in->parser;
+		// a .h2b2 goes in as it is, a .h2b that hasn't been cooked is packed here the way ModelCooker would
+		if (p.IsPacked())
+			std::copy(p.packedVertices.begin(), p.packedVertices.end(), target.vertices + in->vertexStart);
+		else {
+			for (unsigned v = 0; v < p.vertexCount; ++v)
+				target.vertices[in->vertexStart + v] = H2B::PackVertex(p.vertices[v], in->boundsCenter, in->boundsExtent);
+		}
+		if (p.indexSize == 2)
+			std::copy(p.shortIndices.begin(), p.shortIndices.end(), target.indices + in->indexStart);
+		else
+			std::copy(p.indices.begin(), p.indices.end(), target.indices + in->indexStart);
+		std::copy(p.batches.begin(), p.batches.end(), target.batches + in->batchStart);
+	}
 	// internal helper for collecting all .h2b data into unified arrays
 	bool ReadAndCombineH2Bs(const char* h2bFolderPath, const std::vector<MODEL_ENTRY>& modelSet, GW::SYSTEM::GLog log) {
-		// parse each model adding to overall arrays
-		H2B::Parser p; // reads the .h2b format
+		if (modelSet.empty())
+			return true;
 		const std::string modelPath = h2bFolderPath;
+		GW::SYSTEM::GConcurrent threads;
+		threads.Create(true); // no events, we only wait on it
+		const unsigned modelCount = static_cast<unsigned>(modelSet.size());
 
-		for (auto i = modelSet.begin(); i != modelSet.end(); ++i) {
-			if (p.Parse((modelPath + "/" + i->modelFile).c_str())) {
-				// transfer all string data
-				for (int j = 0; j < p.materialCount; ++j) {
-					for (int k = 0; k < 10; ++k) {
-						if (*((&p.materials[j].name) + k) != nullptr)
-							*((&p.materials[j].name) + k) =
-							level_strings.insert(*((&p.materials[j].name) + k)).first->c_str();
-					}
-				}
-				for (int j = 0; j < p.meshCount; ++j) {
-					if (p.meshes[j].name != nullptr)
-						p.meshes[j].name =
-						level_strings.insert(p.meshes[j].name).first->c_str();
-				}
+		// every model is parsed at the same time, each into its own MODEL_IMPORT
+		std::vector<MODEL_IMPORT> imports(modelCount);
+		threads.BranchParallel(ParseModelJob, 1, modelCount, &modelPath, 0, modelSet.data(), 0, imports.data());
+		threads.Converge(0);
+
+		// offsets are a running sum in modelSet order so the level arrays come out the same on every load
+		size_t vertexTotal = levelVertices.size(), indexTotal = levelIndices.size(), batchTotal = levelBatches.size();
+		for (unsigned m = 0; m < modelCount; ++m) {
+			const MODEL_ENTRY* i = &modelSet[m];
+			MODEL_IMPORT& import = imports[m];
+			if (import.found) {
+				const H2B::MappedParser& p = import.parser;
+				import.vertexStart = static_cast<unsigned>(vertexTotal);
+				import.indexStart = static_cast<unsigned>(indexTotal);
+				import.batchStart = static_cast<unsigned>(batchTotal);
+				vertexTotal += p.vertexCount;
+				indexTotal += p.indexCount;
+				batchTotal += p.batches.size();
 				// record source file name & sizes
 				LEVEL_MODEL model;
 				model.filename = level_strings.insert(i->modelFile).first->c_str();
@@ -218,18 +276,30 @@ private:
 				model.indexCount = p.indexCount;
 				model.materialCount = p.materialCount;
 				model.meshCount = p.meshCount;
+				std::memcpy(model.boundsCenter, import.boundsCenter, sizeof(model.boundsCenter));
+				std::memcpy(model.boundsExtent, import.boundsExtent, sizeof(model.boundsExtent));
 				// record offsets
-				model.vertexStart = levelVertices.size();
-				model.indexStart = levelIndices.size();
+				model.vertexStart = import.vertexStart;
+				model.indexStart = import.indexStart;
 				model.materialStart = levelMaterials.size();
-				model.batchStart = levelBatches.size();
+				model.batchStart = import.batchStart;
 				model.meshStart = levelMeshes.size();
-				// append/move all data
-				levelVertices.insert(levelVertices.end(), p.vertices.begin(), p.vertices.end());
-				levelIndices.insert(levelIndices.end(), p.indices.begin(), p.indices.end());
-				levelMaterials.insert(levelMaterials.end(), p.materials.begin(), p.materials.end());
-				levelBatches.insert(levelBatches.end(), p.batches.begin(), p.batches.end());
-				levelMeshes.insert(levelMeshes.end(), p.meshes.begin(), p.meshes.end());
+				// names go straight from the file into level_strings, std::set isn't thread safe so this stays here
+				for (const H2B::MATERIAL_VIEW& view : p.materials) {
+					H2B::MATERIAL material = {};
+					material.attrib = view.attrib;
+					for (int k = 0; k < 10; ++k) {
+						if (k == 0 || view.names[k].empty() == false) // name is never null, see MappedParser::Materialize
+							*((&material.name) + k) = level_strings.emplace(view.names[k]).first->c_str();
+					}
+					levelMaterials.push_back(material);
+				}
+				for (const H2B::MESH_VIEW& view : p.meshes) {
+					H2B::MESH mesh = { nullptr, view.drawInfo, view.materialIndex };
+					if (view.name.empty() == false)
+						mesh.name = level_strings.emplace(view.name).first->c_str();
+					levelMeshes.push_back(mesh);
+				}
 				// add overall collision volume(OBB) for this model and its submeshes 
 				model.colliderIndex = levelColliders.size();
 				levelColliders.push_back(i->ComputeOBB());
@@ -264,6 +334,14 @@ private:
 				log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
 			}
 		}
+
+		// the bulk geometry is copied in parallel, every model owns a separate slice so no locking is needed
+		levelVertices.resize(vertexTotal);
+		levelIndices.resize(indexTotal);
+		levelBatches.resize(batchTotal);
+		IMPORT_TARGET target = { levelVertices.data(), levelIndices.data(), levelBatches.data() };
+		threads.BranchParallel(CopyModelJob, 1, modelCount, &target, 0, modelSet.data(), 0, imports.data());
+		threads.Converge(0);
 		log.LogCategorized("MESSAGE", "Importing of .H2B File Data Complete.");
 		return true;
 	}
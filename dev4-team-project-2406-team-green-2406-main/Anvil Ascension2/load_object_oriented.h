@@ -3,11 +3,20 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "h2bParser.h"
+#include "MeshCache.h"
+#include "TextureCache.h"
+#include "ShaderProgram.h"
+#include "RingBuffer.h"
+#include "RenderQueue.h"
+#include "LevelRenderer.h"
+#include "StaticLayer.h"
 #include "FileIntoString.h"
 #include "components.h"
 #include "gameplay.h"
 #include <vector>
 #include <list>
+#include <unordered_map>
+#include <cstring>
 #include <string>
 #include <chrono>
 
@@ -42,14 +51,41 @@ MessageCallback(GLenum source, GLenum type, GLuint id,
 }
 #endif
 
+// the UboData block, written once a frame and shared by every draw
 struct UBO_DATA {
 	GW::MATH::GVECTORF sunDirection;
 	GW::MATH::GVECTORF sunColor;
 	GW::MATH::GMATRIXF viewMatrix;
 	GW::MATH::GMATRIXF projectionMatrix;
+};
+// the ObjectData block, one per Model drawn without instancing
+struct OBJECT_DATA {
 	GW::MATH::GMATRIXF worldMatrix;
-	GW::MATH::GVECTORF fogColor;
-	float fogDensity;
+};
+// bytes each block takes in std140, a bound range has to cover all of it
+constexpr size_t UBO_BLOCK_SIZE = (sizeof(UBO_DATA) + 15) / 16 * 16;
+constexpr size_t OBJECT_BLOCK_SIZE = (sizeof(OBJECT_DATA) + 15) / 16 * 16;
+// GL_UNIFORM_BUFFER binding points the blocks are read from
+constexpr GLuint FRAME_BINDING = 0, OBJECT_BINDING = 1;
+
+// slots of every uniform the level shader is drawn with, found once after it links
+struct LEVEL_UNIFORMS {
+	int textureDiffuse = -1;
+	int textureLayers = -1;
+	int textureLayer = -1;
+	int ambientColor = -1;
+	int mapCenter = -1;
+	int lightDir = -1;
+	int lightColor = -1;
+	void Find(const ShaderProgram& shader) {
+		textureDiffuse = shader.Uniform("texture_diffuse");
+		textureLayers = shader.Uniform("texture_layers");
+		textureLayer = shader.Uniform("textureLayer");
+		ambientColor = shader.Uniform("ambientColor");
+		mapCenter = shader.Uniform("mapCenter");
+		lightDir = shader.Uniform("lightDir");
+		lightColor = shader.Uniform("lightColor");
+	}
 };
 
 struct Light {
@@ -65,19 +101,14 @@ struct Light {
 class Model {
 	// Name of the Model in the GameLevel (useful for debugging)
 	std::string name;
-	// Loads and stores CPU model data from .h2b file
-	H2B::Parser cpuModel; // reads the .h2b format
+	// Geometry shared with every other Model using the same .h2b
+	MeshCache::MESH* mesh = nullptr;
 	// Shader variables needed by this model. 
 	GW::MATH::GMATRIXF world;
 	GLuint vertexShader = 0;
 	GLuint fragmentShader = 0;
 	GLuint shaderExecutable = 0;
-	GLuint vao = 0;
-	GLuint vertexBufferObject = 0;
-	GLuint indexBufferObject = 0;
-	GLuint textureID = 0;
-	std::vector<H2B::VERTEX> vertices;
-	std::vector<unsigned> indices;
+	TextureCache::TEXTURE* texture = nullptr; // shared with every Model using the same image
 
 
 public:
@@ -155,98 +186,80 @@ public:
 	inline void SetWorldMatrix(GW::MATH::GMATRIXF worldMatrix) {
 		world = worldMatrix;
 	}
-
-	bool LoadModelDataFromDisk(const char* h2bPath) {
-		// if this succeeds "cpuModel" should now contain all the model's info
-		return cpuModel.Parse(h2bPath);
-	}
-
-	bool LoadTextureFromFile(const char* texturePath) {
-		int width, height, nrChannels;
-		unsigned char* data = stbi_load(texturePath, &width, &height, &nrChannels, 0);
-		if (data) {
-			glGenTextures(1, &textureID);
-			glBindTexture(GL_TEXTURE_2D, textureID);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			stbi_image_free(data);
-			return true;
-		}
-		else {
-			stbi_image_free(data);
-			return false;
-		}
+	const GW::MATH::GMATRIXF& GetWorldMatrix() const {
+		return world;
+	}
+	const MeshCache::MESH* GetMesh() const {
+		return mesh;
+	}
+	const TextureCache::TEXTURE* GetTexture() const {
+		return texture;
 	}
 
-	bool UploadModelData2GPU(/*specific API device for loading*/) {
-		vertices = cpuModel.vertices;
-		indices = cpuModel.indices;
-
-		glGenVertexArrays(1, &vao);
-		glBindVertexArray(vao);
-
-		glGenBuffers(1, &vertexBufferObject);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBufferObject);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(H2B::VERTEX), vertices.data(), GL_STATIC_DRAW);
-
-		glGenBuffers(1, &indexBufferObject);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferObject);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
-
-		// Set up vertex attributes
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, pos));
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, uvw));
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, nrm));
-		glEnableVertexAttribArray(2);
-
-		glBindVertexArray(0);
-
-		return true;
-		
+	// only the first Model to ask for an .h2b reads it, the rest share its mesh
+	bool LoadModelDataFromDisk(MeshCache& meshes, const char* h2bPath) {
+		mesh = meshes.Acquire(h2bPath);
+		return mesh != nullptr;
 	}
-	bool DrawModel(GLuint shaderExecutable, UBO_DATA& uboData, GLuint ubo, GW::MATH::GVECTORF mapCenter) {
-		glBindVertexArray(vao);
 
-		// Update world matrix
-		uboData.worldMatrix = world;
-		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(UBO_DATA), &uboData);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	// only the first Model to ask for an image decodes it, the rest share its texture
+	bool LoadTextureFromFile(TextureCache& textures, const char* texturePath) {
+		texture = textures.Acquire(texturePath);
+		return texture != nullptr;
+	}
 
-		// Bind texture
+	// Copies this Model's ObjectData into the ring, its offset or -1 if the ring is full
+	GLintptr WriteConstants(RingBuffer& constants) const {
+		GLintptr offset = -1;
+		OBJECT_DATA* record = static_cast<OBJECT_DATA*>(constants.Allocate(OBJECT_BLOCK_SIZE, offset));
+		if (record == nullptr)
+			return -1;
+		record->worldMatrix = mesh->packed ? UnpackBounds(world) : world;
+		return offset;
+	}
+	// Binding is split from drawing so a sorted queue only rebinds what differs from the Model drawn before.
+	void BindMesh() const {
+		glBindVertexArray(mesh->vao);
+	}
+	// the shader must already be in use with its per frame uniforms set
+	void BindTexture(ShaderProgram& shader, const LEVEL_UNIFORMS& uniforms) const {
+		// Bind texture, texture_diffuse reads unit 0
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glUniform1i(glGetUniformLocation(shaderExecutable, "texture_diffuse"), 0);
-
-		// Set ambient color
-		glUniform3f(glGetUniformLocation(shaderExecutable, "ambientColor"), 0.2f, 0.2f, 0.2f); 
-
-		// Set fog uniforms
-		glUniform3fv(glGetUniformLocation(shaderExecutable, "fogColor"), 1, &uboData.fogColor.x);
-		glUniform1f(glGetUniformLocation(shaderExecutable, "fogDensity"), uboData.fogDensity);
-
-		// Set map center
-		glUniform3fv(glGetUniformLocation(shaderExecutable, "mapCenter"), 1, &mapCenter.x);
-
-		// Ensure the correct shader program is being used
-		glUseProgram(shaderExecutable);
-
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-
-		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, texture->id);
+		// a shader with a sampler2DArray reads the packed layer on unit 1 instead, -1 keeps it on the placeholder
+		if (uniforms.textureLayer != -1) {
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, texture->array);
+			shader.Set(uniforms.textureLayer, texture->ready ? static_cast<GLint>(texture->layer) : -1);
+			glActiveTexture(GL_TEXTURE0);
+		}
+	}
+	// Draws with this Model's mesh and texture already bound.
+	// constantsOffset is where WriteConstants put this Model's ObjectData, the ring must be flushed already.
+	bool DrawModel(GLuint constants, GLintptr constantsOffset) const {
+		if (constantsOffset < 0)
+			return false;
+		glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BINDING, constants, constantsOffset, OBJECT_BLOCK_SIZE);
+		glDrawElements(GL_TRIANGLES, mesh->indexCount, mesh->indexType, 0);
 		return true;
 	}
-	bool FreeResources(/*specific API device for unloading*/) {
-		glDeleteVertexArrays(1, &vao);
-		glDeleteBuffers(1, &vertexBufferObject);
-		glDeleteBuffers(1, &indexBufferObject);
-		glDeleteTextures(1, &textureID);
+	// world matrix for packed positions, scales them out of -1 to 1 and moves them to the bounds center first
+	GW::MATH::GMATRIXF UnpackBounds(const GW::MATH::GMATRIXF& toWorld) const {
+		GW::MATH::GMATRIXF out = toWorld;
+		for (int column = 0; column < 4; ++column) {
+			out.data[0 + column] = toWorld.data[0 + column] * mesh->boundsExtent[0];
+			out.data[4 + column] = toWorld.data[4 + column] * mesh->boundsExtent[1];
+			out.data[8 + column] = toWorld.data[8 + column] * mesh->boundsExtent[2];
+			out.data[12 + column] = toWorld.data[12 + column] + mesh->boundsCenter[0] * toWorld.data[0 + column] +
+				mesh->boundsCenter[1] * toWorld.data[4 + column] + mesh->boundsCenter[2] * toWorld.data[8 + column];
+		}
+		return out;
+	}
+	bool FreeResources(MeshCache& meshes, TextureCache& textures) {
+		meshes.Release(mesh);
+		mesh = nullptr;
+		textures.Release(texture);
+		texture = nullptr;
 		return true;
 	}
 }; 
@@ -263,14 +276,36 @@ class Level_Objects {
 	GW::MATH::GVECTORF mapCenter;
 	GW::SYSTEM::GWindow win;
 	GW::GRAPHICS::GOpenGLSurface ogl;
+	LevelText::Parser levelText; // buffer is reused by every text level load
+	MeshCache meshes; // one upload per unique .h2b, shared by every Model using it
+	TextureCache textures; // one decode and upload per unique image
+	static constexpr size_t TEXTURE_UPLOAD_BUDGET = 16 * 1024 * 1024; // bytes of texels sent to the GPU per frame
 	std::shared_ptr<Level_Data> levelData;
 	std::shared_ptr<flecs::world> world;
 
 	// Global variables
 	
-	UBO_DATA uboData;
-	GLuint ubo = 0;
-	GLuint shaderExecutable = 0;
+	UBO_DATA uboData; // this frame's UboData, written into the ring once
+	RingBuffer constants; // this frame's UboData record and, without instancing, an ObjectData record per Model
+	std::vector<GLintptr> constantsOffsets; // where each Model's record went this frame
+	// every Model in list order, with dense ids for its texture and mesh small enough for the queue's key
+	struct DRAW_SOURCE {
+		Model* model;
+		unsigned texture, mesh;
+	};
+	std::vector<DRAW_SOURCE> drawSources;
+	RenderQueue queue; // this frame's Models sorted so ones sharing a texture and mesh draw back to back
+	static constexpr unsigned OPAQUE_PASS = 0;
+	static constexpr float NEAR_PLANE = 0.1f, FAR_PLANE = 100.0f;
+	size_t uniformAlignment = 256;
+	size_t uploadedBytes = 0;
+	ShaderProgram shader;
+	LEVEL_UNIFORMS uniforms;
+	Level_Renderer instanced; // draws levelData one call per model instead of one per object
+	LEVEL_UNIFORMS instancedUniforms;
+	bool useInstancing = false;
+	StaticLayer background; // models without a Dynamic entity, drawn once and blitted in under the rest each frame
+	UBO_DATA backgroundFrame = {}; // frame data background was drawn with
 	std::vector<Light> lights;
 	GW::MATH::GVECTORF sunDirection;
 	GW::MATH::GVECTORF sunColor;
@@ -283,16 +318,30 @@ class Level_Objects {
 public:
 	Level_Objects() = default;
 
-	GLuint GetShaderProgram() const {
-		return shaderExecutable;
+	// bytes of constants, matrices and draw commands the last RenderLevel wrote for the GPU
+	size_t UploadedBytes() const {
+		return uploadedBytes;
+	}
+	// draws of the last frame on the instanced path, only the moving models once the background layer is in use
+	size_t InstancedDrawCount() const {
+		return instanced.DrawCallCount();
+	}
+	// times the scenery had to be drawn again into the background layer
+	size_t BackgroundBakeCount() const {
+		return background.BakeCount();
+	}
+	// the per Model draws of the last frame, with how many binds sorting let it skip
+	const RenderQueue& GetRenderQueue() const {
+		return queue;
 	}
 
 	Level_Objects(GW::SYSTEM::GWindow _win, GW::GRAPHICS::GOpenGLSurface _ogl, std::shared_ptr<Level_Data> _levelData, std::shared_ptr<flecs::world> _world)
 		: win(_win), ogl(_ogl), levelData(_levelData), world(_world) {
 		InitializeMatricesAndLighting();
-		InitializeUBO();
 		CompileShaders();
-		glUseProgram(shaderExecutable);
+		InitializeUBO();
+		// same sized level textures share an array when the shader can index one, so batches don't rebind per Model
+		textures.UseArrays((useInstancing ? instancedUniforms : uniforms).textureLayers != -1);
 		win.GetClientWidth(width);
 		win.GetClientHeight(height);
 		FOV = 65.0f * (G_PI_F / 180.0f);
@@ -315,119 +364,161 @@ public:
 	// Imports the default level txt format and creates a Model from each .h2b
 	bool LoadLevel(const char* gameLevelPath, const char* h2bFolderPath, GW::SYSTEM::GLog log) {
 		log.LogCategorized("EVENT", "LOADING GAME LEVEL [OBJECT ORIENTED]");
-		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
 
 		UnloadLevel(); // clear previous level data if there is any
-		GW::SYSTEM::GFile file;
-		file.Create();
-		if (-file.OpenTextRead(gameLevelPath)) {
+		LVLB::Level cooked;
+		if (cooked.OpenCooked(gameLevelPath))
+			return LoadCookedLevel(cooked, h2bFolderPath, log);
+
+		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
+		if (levelText.Load(gameLevelPath) == false) {
 			log.LogCategorized("ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
 			return false;
 		}
-		char linebuffer[1024];
-		while (+file.ReadLine(linebuffer, 1024, '\n')) {
-			if (linebuffer[0] == '\0')
-				break;
-			if (std::strcmp(linebuffer, "MESH") == 0) {
-				Model newModel;
-				file.ReadLine(linebuffer, 1024, '\n');
-				newModel.SetName(linebuffer);
-				std::string modelFile = linebuffer;
-				modelFile = modelFile.substr(0, modelFile.find_last_of("."));
-				modelFile += ".h2b";
-
-				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
-						&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-						&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-
-				modelFile = std::string(h2bFolderPath) + "/" + modelFile;
-				newModel.SetWorldMatrix(transform);
-				if (newModel.LoadModelDataFromDisk(modelFile.c_str())) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					if (std::strcmp(linebuffer, "TEXTURE") == 0) {
-						file.ReadLine(linebuffer, 1024, '\n');
-						std::string textureFile = linebuffer;
-						if (newModel.LoadTextureFromFile(textureFile.c_str())) {
-							allObjectsInLevel.push_back(std::move(newModel));
-						}
-						else {
-							log.LogCategorized("ERROR", (std::string("Texture Not Found: ") + textureFile).c_str());
-						}
-					}
-					else {
-						log.LogCategorized("ERROR", "Texture information missing in game level file.");
-					}
-				}
-				else {
-					log.LogCategorized("ERROR", (std::string("H2B Not Found: ") + modelFile).c_str());
-					log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
-				}
-			}
-			else if (std::strcmp(linebuffer, "LIGHT") == 0) {
-				file.ReadLine(linebuffer, 1024, '\n'); // Read the type
-				std::string lightType = linebuffer;
-
-				if (lightType == "SUN") {
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the color
-					float r, g, b;
-					std::sscanf(linebuffer, "Color: %f %f %f", &r, &g, &b);
-					sunColor = { r, g, b, 1.0f };
-
-					file.ReadLine(linebuffer, 1024, '\n'); // Read the direction
-					float x, y, z;
-					std::sscanf(linebuffer, "Direction: %f %f %f", &x, &y, &z);
-					sunDirection = { x, y, z, 0.0f };
-
-					log.LogCategorized("INFO", "Sun data parsed successfully.");
-				}
-			}
-		}
+		std::string modelFile; // reused so each entry doesn't allocate a new path
+		levelText.Parse([&](const LevelText::MESH& mesh) {
+			modelFile.assign(h2bFolderPath).append("/");
+			modelFile.append(mesh.ModelName().data(), mesh.ModelName().size()).append(".h2b");
+			GW::MATH::GMATRIXF transform;
+			std::memcpy(transform.data, mesh.transform, sizeof(transform.data));
+			std::string texturePath(mesh.texturePath.data(), mesh.texturePath.size());
+			AddModel(std::string(mesh.blenderName.data(), mesh.blenderName.size()), modelFile, transform,
+				mesh.texturePath.empty() ? nullptr : texturePath.c_str(), log);
+		}, [&](const LevelText::LIGHT& light) {
+			SetSun(light.color, light.direction, log);
+		});
 		log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
+		LogAssetSharing(log);
+		log.LogCategorized("EVENT", "GAME LEVEL WAS LOADED TO CPU [OBJECT ORIENTED]");
+		return true;
+	}
+	// Same as LoadLevel but every entry comes straight out of a mapped .lvlb
+	bool LoadCookedLevel(const LVLB::Level& cooked, const char* h2bFolderPath, GW::SYSTEM::GLog log) {
+		log.LogCategorized("MESSAGE", "Reading Cooked Game Level.");
+		for (unsigned i = 0; i < cooked.ObjectCount(); ++i) {
+			const LVLB::OBJECT& object = cooked.Objects()[i];
+			GW::MATH::GMATRIXF transform;
+			std::memcpy(&transform, &cooked.Transforms()[i], sizeof(transform));
+			AddModel(cooked.String(object.blenderName),
+				std::string(h2bFolderPath) + "/" + cooked.String(object.modelFile),
+				transform, cooked.String(object.texturePath), log);
+		}
+		for (unsigned i = 0; i < cooked.LightCount(); ++i) {
+			const LVLB::LIGHT& light = cooked.Lights()[i];
+			if (std::strcmp(cooked.String(light.type), "SUN") == 0)
+				SetSun(light.color, light.direction, log);
+		}
+		log.LogCategorized("MESSAGE", "Cooked Game Level Reading Complete.");
+		LogAssetSharing(log);
 		log.LogCategorized("EVENT", "GAME LEVEL WAS LOADED TO CPU [OBJECT ORIENTED]");
 		return true;
 	}
+	// Loads one level entry's model and texture, entries missing either are logged and left out
+	void AddModel(const std::string& name, const std::string& modelFile, const GW::MATH::GMATRIXF& transform,
+		const char* texturePath, GW::SYSTEM::GLog log) {
+		// the instanced path draws from levelData and acquires its own textures, a Model would never be drawn
+		if (useInstancing)
+			return;
+		Model newModel;
+		newModel.SetName(name);
+		newModel.SetWorldMatrix(transform);
+		if (newModel.LoadModelDataFromDisk(meshes, modelFile.c_str()) == false) {
+			log.LogCategorized("ERROR", (std::string("H2B Not Found: ") + modelFile).c_str());
+			log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
+			return;
+		}
+		if (texturePath == nullptr) {
+			log.LogCategorized("ERROR", "Texture information missing in game level file.");
+		}
+		else if (newModel.LoadTextureFromFile(textures, texturePath)) {
+			allObjectsInLevel.push_back(std::move(newModel));
+			return;
+		}
+		else {
+			log.LogCategorized("ERROR", (std::string("Texture Not Found: ") + texturePath).c_str());
+		}
+		newModel.FreeResources(meshes, textures); // left out of the level, give its mesh back
+	}
+	// unique assets against how many Models use them, for the memory reports
+	void LogAssetSharing(GW::SYSTEM::GLog log) const {
+		if (useInstancing)
+			return; // nothing was acquired per Model
+		log.LogCategorized("INFO", (std::to_string(meshes.MeshCount()) + " unique meshes shared by " +
+			std::to_string(meshes.ReferenceCount()) + " models").c_str());
+		log.LogCategorized("INFO", (std::to_string(textures.TextureCount()) + " unique textures shared by " +
+			std::to_string(textures.ReferenceCount()) + " models, decoding in the background").c_str());
+	}
+	void SetSun(const float color[3], const float direction[3], GW::SYSTEM::GLog log) {
+		sunColor = { color[0], color[1], color[2], 1.0f };
+		sunDirection = { direction[0], direction[1], direction[2], 0.0f };
+		log.LogCategorized("INFO", "Sun data parsed successfully.");
+	}
 	// Upload the CPU level to GPU
 	void UploadLevelToGPU(/*pass handle to API device if needed*/) {
-		// iterate over each model and tell it to draw itself
-		for (auto& e : allObjectsInLevel) {
-			e.UploadModelData2GPU(/*forward handle to API device if needed*/);
+		// the instanced path draws straight from levelData, the per Model meshes are only needed without it
+		if (useInstancing) {
+			instanced.Upload(levelData, textures);
+			background.Invalidate(); // a new level has different scenery
+		}
+		else {
+			meshes.UploadPending(); // each unique mesh is uploaded once no matter how many Models share it
+			constants.Reserve(GL_UNIFORM_BUFFER, RecordSize(UBO_BLOCK_SIZE) + allObjectsInLevel.size() * RecordSize(OBJECT_BLOCK_SIZE), uniformAlignment);
+			AssignDrawIds();
+		}
+	}
+	// Numbers every unique texture and mesh in the order Models first use them
+	void AssignDrawIds() {
+		std::unordered_map<const void*, unsigned> textureIds, meshIds;
+		drawSources.clear();
+		for (Model& model : allObjectsInLevel) {
+			unsigned texture = textureIds.emplace(model.GetTexture(), static_cast<unsigned>(textureIds.size())).first->second;
+			unsigned mesh = meshIds.emplace(model.GetMesh(), static_cast<unsigned>(meshIds.size())).first->second;
+			drawSources.push_back({ &model, texture, mesh });
 		}
 	}
+	// 0 at the near plane to 1 at the far one, taken at the world matrix's origin
+	float ViewDepth(const GW::MATH::GMATRIXF& toWorld) const {
+		// z of the position times the view matrix, the camera looks down -z
+		float z = toWorld.data[12] * view.data[2] + toWorld.data[13] * view.data[6] + toWorld.data[14] * view.data[10] + view.data[14];
+		return (-z - NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+	}
 	// Draws all objects in the level
 	void RenderLevel() {
-		glUseProgram(shaderExecutable);
-		glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+		// textures decoded since last frame replace their placeholders, a few at a time
+		bool texturesChanging = textures.PendingCount() > 0;
+		textures.UploadFinished(TEXTURE_UPLOAD_BUDGET);
+		constants.BeginFrame();
 		UpdateUBO();
-
-		// Set light properties uniforms
-		GLint lightDirLocation = glGetUniformLocation(shaderExecutable, "lightDir");
-		GLint lightColorLocation = glGetUniformLocation(shaderExecutable, "lightColor");
-
-		if (lightDirLocation == -1 || lightColorLocation == -1) {
-			std::cerr << "Failed to get uniform location for lightDir or lightColor." << std::endl;
-		}
-		else {
-			if (!lights.empty()) {
-				glUniform3fv(lightDirLocation, 1, &sunDirection.x);
-				glUniform3fv(lightColorLocation, 1, &sunColor.x);
-			}
-			else {
-				// Fallback to hardcoded values if no lights are available
-				GW::MATH::GVECTORF hardcodedLightDir = { 0.5f, 1.0f, 0.3f };
-				GW::MATH::GVECTORF hardcodedLightColor = { 1.0f, 1.0f, 1.0f };
-				glUniform3fv(lightDirLocation, 1, &hardcodedLightDir.x);
-				glUniform3fv(lightColorLocation, 1, &hardcodedLightColor.x);
-			}
+		// both paths share one UboData for the frame, instances carry their own world matrix
+		GLintptr frameOffset = WriteFrameConstants();
+		if (useInstancing) {
+			constants.Flush();
+			if (frameOffset >= 0)
+				glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BINDING, constants.Id(), frameOffset, UBO_BLOCK_SIZE);
+			instanced.GetShader().Use();
+			size_t uniformUploads = instanced.GetShader().UploadCount();
+			SetFrameUniforms(instanced.GetShader(), instancedUniforms);
+			bool lookChanged = texturesChanging || instanced.GetShader().UploadCount() != uniformUploads;
+			GW::MATH::GMATRIXF viewProjection;
+			matrixProxy.MultiplyMatrixF(view, projection, viewProjection);
+			uploadedBytes = 0;
+			// the scenery comes from the background layer, only what moves is drawn every frame
+			if (PrepareBackground(lookChanged, viewProjection) && background.Present())
+				instanced.Render(*world, viewProjection, Level_Renderer::DYNAMIC_OBJECTS);
+			else
+				instanced.Render(*world, viewProjection);
+			constants.EndFrame();
+			uploadedBytes += constants.LastFrameBytes() + instanced.UploadedBytes();
+			return;
 		}
-
-		for (auto& e : allObjectsInLevel) {
+		shader.Use();
+		SetFrameUniforms(shader, uniforms);
+
+		// every record is written before the first draw, the ring can't be read from while it's being mapped
+		constantsOffsets.clear();
+		queue.Clear();
+		for (unsigned i = 0; i < drawSources.size(); ++i) {
+			Model& e = *drawSources[i].model;
 			// Update the world matrix from the corresponding Flecs entity
 			auto flecsEntity = world->lookup(e.GetName().c_str());
 			if (flecsEntity.is_valid()) {
@@ -436,59 +527,112 @@ public:
 					e.SetWorldMatrix(transform->matrix);
 				}
 			}
-			e.DrawModel(shaderExecutable, uboData, ubo, mapCenter);
+			constantsOffsets.push_back(e.WriteConstants(constants));
+			queue.Push(RenderQueue::MakeKey(OPAQUE_PASS, 0, drawSources[i].texture, drawSources[i].mesh,
+				ViewDepth(e.GetWorldMatrix())), i);
+		}
+		constants.Flush();
+		if (frameOffset >= 0)
+			glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BINDING, constants.Id(), frameOffset, UBO_BLOCK_SIZE);
+		queue.Sort();
+		queue.Submit([this](unsigned i, unsigned changed) {
+			const Model& e = *drawSources[i].model;
+			if (changed & RenderQueue::PROGRAM_CHANGED)
+				shader.Use();
+			if (changed & RenderQueue::MESH_CHANGED)
+				e.BindMesh();
+			if (changed & RenderQueue::TEXTURE_CHANGED)
+				e.BindTexture(shader, uniforms);
+			e.DrawModel(constants.Id(), constantsOffsets[i]);
+		});
+		glBindVertexArray(0);
+		constants.EndFrame();
+		uploadedBytes = constants.LastFrameBytes();
+	}
+	// Redraws the static models into background if it no longer matches the window or what they'd look like now.
+	// false when there's no background layer to use.
+	bool PrepareBackground(bool lookChanged, const GW::MATH::GMATRIXF& viewProjection) {
+		unsigned int windowWidth, windowHeight;
+		win.GetClientWidth(windowWidth);
+		win.GetClientHeight(windowHeight);
+		if (background.Resize(windowWidth, windowHeight) == false)
+			return false;
+		// a model that gained or lost its Dynamic entities moves between the layer and the per frame pass
+		bool sceneryChanged = instanced.StaticModelsChanged(*world);
+		// view, projection and sun all reach the shader through the frame's UboData
+		if (sceneryChanged || lookChanged || std::memcmp(&backgroundFrame, &uboData, sizeof(UBO_DATA)) != 0)
+			background.Invalidate();
+		if (background.IsValid() == false) {
+			background.BeginBake();
+			instanced.Render(*world, viewProjection, Level_Renderer::STATIC_OBJECTS);
+			background.EndBake();
+			backgroundFrame = uboData;
+			uploadedBytes += instanced.UploadedBytes();
 		}
+		return true;
 	}
 	// used to wipe CPU & GPU level data between levels
 	void UnloadLevel() {
 		for (auto& e : allObjectsInLevel) {
-			e.FreeResources();
+			e.FreeResources(meshes, textures);
 		}
 		allObjectsInLevel.clear();
+		drawSources.clear();
+		instanced.Unload(textures);
 		lights.clear();
 	}
 
+	// bytes a block of blockSize takes in the constants ring, bound ranges have to start on the GL's alignment
+	size_t RecordSize(size_t blockSize) const {
+		return (blockSize + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+	}
+
 	void InitializeUBO() {
-		glGenBuffers(1, &ubo);
-		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-		glBufferData(GL_UNIFORM_BUFFER, sizeof(UBO_DATA), nullptr, GL_STATIC_DRAW);
-		glUseProgram(shaderExecutable);
-		GLuint uboIndex = glGetUniformBlockIndex(shaderExecutable, "UboData");
-		if (uboIndex != GL_INVALID_INDEX) {
-			glUniformBlockBinding(shaderExecutable, uboIndex, 0);
-			glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
-		}
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if (alignment > 0)
+			uniformAlignment = static_cast<size_t>(alignment);
+		// room for the per frame record until a level says how many Models it has
+		constants.Reserve(GL_UNIFORM_BUFFER, RecordSize(UBO_BLOCK_SIZE), uniformAlignment);
+		shader.BindBlock("UboData", FRAME_BINDING);
+		shader.BindBlock("ObjectData", OBJECT_BINDING);
+		if (useInstancing)
+			instanced.GetShader().BindBlock("UboData", FRAME_BINDING);
 	}
 
+	// Refreshes the per frame part of UboData, what goes to the GPU is written from it into the constants ring
 	void UpdateUBO() {
 		uboData.viewMatrix = view;
 		uboData.projectionMatrix = projection;
 		uboData.sunDirection = sunDirection; // Use the parsed sun direction
 		uboData.sunColor = sunColor; // Use the parsed sun color
-		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(UBO_DATA), &uboData);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
-
-		// Set the light direction and color uniforms
-		GLint lightDirLocation = glGetUniformLocation(shaderExecutable, "lightDir");
-		GLint lightColorLocation = glGetUniformLocation(shaderExecutable, "lightColor");
-		glUseProgram(shaderExecutable);
-		glUniform3fv(lightDirLocation, 1, &uboData.sunDirection.x);
-		glUniform3fv(lightColorLocation, 1, &uboData.sunColor.x);
-
-		GLint fogColorLocation = glGetUniformLocation(shaderExecutable, "fogColor");
-		GLint fogDensityLocation = glGetUniformLocation(shaderExecutable, "fogDensity");
-		glUniform3fv(fogColorLocation, 1, &uboData.fogColor.x);
-		glUniform1f(fogDensityLocation, uboData.fogDensity);
+	}
+	// one UboData for the whole frame, its offset in the ring or -1 if there was no room
+	GLintptr WriteFrameConstants() {
+		GLintptr offset = -1;
+		UBO_DATA* record = static_cast<UBO_DATA*>(constants.Allocate(UBO_BLOCK_SIZE, offset));
+		if (record == nullptr)
+			return -1;
+		*record = uboData;
+		return offset;
+	}
+	// Set the light and map center uniforms on the program in use, only sent when they change
+	void SetFrameUniforms(ShaderProgram& program, const LEVEL_UNIFORMS& slots) {
+		if (!lights.empty()) {
+			program.Set(slots.lightDir, uboData.sunDirection);
+			program.Set(slots.lightColor, uboData.sunColor);
+		}
+		else {
+			// Fallback to hardcoded values if no lights are available
+			program.Set(slots.lightDir, GW::MATH::GVECTORF{ 0.5f, 1.0f, 0.3f });
+			program.Set(slots.lightColor, GW::MATH::GVECTORF{ 1.0f, 1.0f, 1.0f });
+		}
 
-		GLint mapCenterLocation = glGetUniformLocation(shaderExecutable, "mapCenter");
-		glUniform3fv(mapCenterLocation, 1, &mapCenter.x);
+		program.Set(slots.ambientColor, GW::MATH::GVECTORF{ 0.2f, 0.2f, 0.2f });
+		program.Set(slots.mapCenter, mapCenter);
 	}
 
 	void InitializeMatricesAndLighting() {
-		matrixProxy.IdentityF(uboData.worldMatrix);
-
 		//Camera//
 		GW::MATH::GVECTORF cameraPosition = { -0.2f, 2.0f, 3.3f };
 		GW::MATH::GVECTORF targetPosition = { -0.2f, 2.0f, 0.0f };
@@ -501,7 +645,7 @@ public:
 		win.GetClientHeight(height);
 		float fov = 110.0f * (G_PI_F / 180.0f);
 		float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
-		matrixProxy.ProjectionOpenGLRHF(fov, aspectRatio, 0.1f, 100.0f, projection);
+		matrixProxy.ProjectionOpenGLRHF(fov, aspectRatio, NEAR_PLANE, FAR_PLANE, projection);
 
 		vectorProxy.NormalizeF(sunDirection, uboData.sunDirection);
 		uboData.sunColor = sunColor;
@@ -511,55 +655,26 @@ public:
 
 
 	void CompileShaders() {
-		char errors[1024];
-		GLint result;
-
-		// Vertex Shader
-		GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-		std::string vertexShaderSource = ReadFileIntoString("../Shaders/VertexShader.glsl");
-		const GLchar* vertexStrings[1] = { vertexShaderSource.c_str() };
-		const GLint vertexLengths[1] = { vertexShaderSource.length() };
-		glShaderSource(vertexShader, 1, vertexStrings, vertexLengths);
-		glCompileShader(vertexShader);
-		glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &result);
-		if (result == false) {
-			glGetShaderInfoLog(vertexShader, 1024, NULL, errors);
-			PrintLabeledDebugString("Vertex Shader Errors:\n", errors);
+		if (shader.Create("../Shaders/VertexShader.glsl", "../Shaders/FragmentShader.glsl") == false) {
+			PrintLabeledDebugString("", shader.Errors().c_str());
 			abort();
 		}
+		uniforms.Find(shader);
+		if (uniforms.lightDir == -1 || uniforms.lightColor == -1)
+			std::cerr << "Failed to get uniform location for lightDir or lightColor." << std::endl;
 
-		// Fragment Shader
-		GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-		std::string fragmentShaderSource = ReadFileIntoString("../Shaders/FragmentShader.glsl");
-		const GLchar* fragmentStrings[1] = { fragmentShaderSource.c_str() };
-		const GLint fragmentLengths[1] = { fragmentShaderSource.length() };
-		glShaderSource(fragmentShader, 1, fragmentStrings, fragmentLengths);
-		glCompileShader(fragmentShader);
-		glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &result);
-		if (result == false) {
-			glGetShaderInfoLog(fragmentShader, 1024, NULL, errors);
-			PrintLabeledDebugString("Fragment Shader Errors:\n", errors);
-			abort();
-		}
+		// Use the shader program, samplers never change units so they're set once here
+		shader.Use();
+		shader.Set(uniforms.textureDiffuse, 0);
+		shader.Set(uniforms.textureLayers, 1);
 
-		// Link Shader Program
-		shaderExecutable = glCreateProgram();
-		glAttachShader(shaderExecutable, vertexShader);
-		glAttachShader(shaderExecutable, fragmentShader);
-		glLinkProgram(shaderExecutable);
-		glGetProgramiv(shaderExecutable, GL_LINK_STATUS, &result);
-		if (result == false) {
-			glGetProgramInfoLog(shaderExecutable, 1024, NULL, errors);
-			PrintLabeledDebugString("Shader Program Linking Errors:\n", errors);
-			abort();
+		// every level object is drawn instanced when that shader builds, one Model at a time otherwise
+		if (instanced.Create()) {
+			instancedUniforms.Find(instanced.GetShader());
+			useInstancing = true;
 		}
-
-		// Cleanup shaders (no longer needed once linked)
-		glDeleteShader(vertexShader);
-		glDeleteShader(fragmentShader);
-
-		// Use the shader program
-		glUseProgram(shaderExecutable);
+		else
+			PrintLabeledDebugString("Instanced rendering off, drawing per Model:\n", instanced.GetShader().Errors().c_str());
 	}
 
 	void ChangeLevel(const char* levelPath, const char* modelPath, std::shared_ptr<Level_Data>& gameLevel, Level_Objects& objectOrientedLoader, std::unique_ptr<Gameplay>& engine, GW::SYSTEM::GLog& log)
@@ -572,12 +687,14 @@ public:
 		if (newGameLevel->LoadLevel(levelPath, modelPath, log))
 		{
 			gameLevel = newGameLevel;
+			objectOrientedLoader.levelData = gameLevel;
 
 			objectOrientedLoader.LoadLevel(levelPath, modelPath, log);
 			objectOrientedLoader.UploadLevelToGPU();
 
 
 			engine = std::make_unique<Gameplay>(*gameLevel, log);
+			objectOrientedLoader.world = engine->GetWorld(); // entities of the new level move the objects now
 		}
 		else
 		{
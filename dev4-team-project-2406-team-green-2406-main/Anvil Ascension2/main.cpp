@@ -20,7 +20,10 @@
 #include "components.h"
 #include "flecs-3.2.0/flecs.h"
 #include "gameplay.h"
-#include <cstring> 
+#include "../Shared/FramePacer.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 
 // open some namespaces to compact the code a bit
 using namespace GW;
@@ -29,6 +32,54 @@ using namespace SYSTEM;
 using namespace GRAPHICS;
 using namespace INPUT;
 
+// frame pacing, vsync locks swaps to the display and the pacer caps the loop when vsync is off or unavailable
+struct WindowSettings {
+    bool vsync = true;
+    unsigned fps = 60; // 0 = uncapped
+};
+
+// Reads the [Window] keys out of Settings.ini, anything missing or unreadable keeps its default
+WindowSettings ReadWindowSettings(const char* path)
+{
+    WindowSettings settings;
+    std::ifstream file(path);
+    std::string line;
+    bool inWindow = false; // keys under any other section aren't ours
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty() && line[0] == '[')
+        {
+            inWindow = line == "[Window]";
+            continue;
+        }
+        size_t equals = line.find('=');
+        if (!inWindow || line.empty() || line[0] == ';' || equals == std::string::npos)
+            continue;
+        std::string key = line.substr(0, equals), value = line.substr(equals + 1);
+        if (key == "vsync")
+        {
+            if (value == "true" || value == "1")
+                settings.vsync = true;
+            else if (value == "false" || value == "0")
+                settings.vsync = false;
+        }
+        else if (key == "fps" && !value.empty() && value[0] >= '0' && value[0] <= '9')
+        {
+            char* end = nullptr;
+            unsigned long fps = std::strtoul(value.c_str(), &end, 10);
+            if (*end == '\0')
+                settings.fps = static_cast<unsigned>(fps);
+        }
+    }
+    return settings;
+}
+
+// Gameplay speeds were tuned stepping 0.1 every frame at 60 frames a second
+constexpr float GAME_SPEED = 0.1f * 60.0f;
+// longest step gameplay takes, so a hitch doesn't send the ball through a wall
+constexpr float MAX_FRAME_SECONDS = 0.1f;
 
 // lets pop a window and use OpenGL to clear to a green screen
 int main(GW::INPUT::GInput& input)
@@ -48,17 +99,15 @@ int main(GW::INPUT::GInput& input)
 
     float toggleKey = 0;
 
-
-    static auto startTime = std::chrono::high_resolution_clock::now();
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float timeElapsed = std::chrono::duration<float>(currentTime - startTime).count();
-
     auto gameLevel = std::make_shared<Level_Data>();
+    // gameplay, the instanced renderer and the per Model fallback all read this one level,
+    // so the level drawn doesn't depend on which renderer the GL could build
+    const char* levelPath = "../GameLevel_1.txt";
 
     log.Create("../LevelLoaderLog.txt");
     log.EnableConsoleLogging(true); // mirror output to the console
     log.Log("Start Program.");
-    if (false == gameLevel->LoadLevel("../GameLevel_1.txt", "../Models", log))
+    if (false == gameLevel->LoadLevel(levelPath, "../Models", log))
         log.LogCategorized("ERROR", "Failed to Load Game Level");
     // import level data into Gameplay engine (FLECS)
     log.LogCategorized("GAMEPLAY", "Begin injecting Blender objects as FLECS entities.");
@@ -104,11 +153,22 @@ int main(GW::INPUT::GInput& input)
         if (+ogl.Create(win, GW::GRAPHICS::DEPTH_BUFFER_SUPPORT))
         {
             QueryOGLExtensionFunctions(ogl); // Link Needed OpenGL API functions
+            WindowSettings settings = ReadWindowSettings("../Settings.ini");
+            bool swapLocked = false; // vsync is holding the loop to the display
+            if (+ogl.EnableSwapControl(settings.vsync))
+                swapLocked = settings.vsync;
+            else if (settings.vsync)
+                log.LogCategorized("WARNING", "Failed to set vsync, relying on the frame pacer.");
             Level_Objects objectOrientedLoader(win, ogl, gameLevel, engine->GetWorld());
-            objectOrientedLoader.LoadLevel("../GameLevel_4.txt", "../Models", log);
+            objectOrientedLoader.LoadLevel(levelPath, "../Models", log);
             objectOrientedLoader.UploadLevelToGPU();
 
-            GLuint shaderProgram = objectOrientedLoader.GetShaderProgram();
+            // start pacing once loading is done so the first frame isn't counted late,
+            // and only when vsync is off since sleeping to a cap on top of it makes the two fight
+            FramePacer framePacer;
+            framePacer.SetTargetFPS(swapLocked ? 0 : settings.fps);
+            auto previousFrame = std::chrono::steady_clock::now();
+            size_t uploadedBytes = 0; // constants and instance data written for the GPU, over every frame
 
             /*IMGUI_CHECKVERSION();
             ImGui::CreateContext();
@@ -126,19 +186,34 @@ int main(GW::INPUT::GInput& input)
                 /*ImGui_ImplOpenGL3_NewFrame();
                 ImGui::NewFrame();*/
 
-                GLint timeLocation = glGetUniformLocation(shaderProgram, "time");
-                glUseProgram(shaderProgram);
-                glUniform1f(timeLocation, timeElapsed);
-                
                 objectOrientedLoader.CheckForLevelChange(gameLevel, objectOrientedLoader, engine, kbm, log);
 
                 objectOrientedLoader.RenderLevel();
+                uploadedBytes += objectOrientedLoader.UploadedBytes();
                 
-                engine->Update(*gameLevel, log, kbm, 0.1f);
+                // step gameplay by however long the last frame really took
+                auto frameStart = std::chrono::steady_clock::now();
+                float frameSeconds = std::chrono::duration<float>(frameStart - previousFrame).count();
+                previousFrame = frameStart;
+                engine->Update(*gameLevel, log, kbm, (frameSeconds < MAX_FRAME_SECONDS ? frameSeconds : MAX_FRAME_SECONDS) * GAME_SPEED);
 
                 ogl.UniversalSwapBuffers();
-
-            }         
+                // Sleep off the rest of the frame when the pacer is on
+                framePacer.Wait();
+            }
+            log.LogCategorized("PACING", (std::to_string(framePacer.GetMissedDeadlines()) + " of " +
+                std::to_string(framePacer.GetFrameCount()) + " frame deadlines missed.").c_str());
+            if (framePacer.GetFrameCount() > 0)
+                log.LogCategorized("UPLOADS", (std::to_string(uploadedBytes / framePacer.GetFrameCount()) +
+                    " bytes of per frame data written on average.").c_str());
+            const RenderQueue& queue = objectOrientedLoader.GetRenderQueue();
+            if (queue.ItemCount() > 0)
+                log.LogCategorized("STATE", (std::to_string(queue.StateChangesAvoided()) + " of " +
+                    std::to_string(queue.StateChangeCount() + queue.StateChangesAvoided()) +
+                    " program, texture and mesh binds skipped by sorting the last frame.").c_str());
+            log.LogCategorized("STATE", (std::to_string(objectOrientedLoader.BackgroundBakeCount()) +
+                " background layer redraws, the last frame drew " + std::to_string(objectOrientedLoader.InstancedDrawCount()) +
+                " instanced batches on top.").c_str());
         }
     }
     /*ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,58 @@
+#pragma once
+// The frame pacer is responsible for holding the main loop to a target frame rate without burning a core
+
+#include <chrono>
+#include <thread>
+
+// Most of the wait is spent asleep, the last sliver is spun on since OS sleeps tend to overshoot.
+class FramePacer
+{
+	using Clock = std::chrono::steady_clock;
+
+	Clock::duration framePeriod = Clock::duration::zero(); // zero means uncapped
+	Clock::time_point deadline; // when the current frame is allowed to end
+	// how close to the deadline we stop sleeping and start spinning
+	Clock::duration spinMargin = std::chrono::milliseconds(2);
+	unsigned long long framesPaced = 0;
+	unsigned long long missedDeadlines = 0;
+public:
+	// 0 disables pacing (vsync or nothing will limit the loop)
+	void SetTargetFPS(unsigned fps) {
+		framePeriod = (fps > 0) ?
+			std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps))
+			: Clock::duration::zero();
+		deadline = Clock::now() + framePeriod;
+	}
+
+	bool IsEnabled() const {
+		return framePeriod != Clock::duration::zero();
+	}
+
+	// Call once per frame after presenting, returns false if the frame ran past its deadline
+	bool Wait() {
+		++framesPaced;
+		if (IsEnabled() == false)
+			return true;
+		Clock::time_point now = Clock::now();
+		if (now > deadline) {
+			// late, don't try to make the time up or the next frames will all rush
+			++missedDeadlines;
+			deadline = now + framePeriod;
+			return false;
+		}
+		if (deadline - now > spinMargin)
+			std::this_thread::sleep_for(deadline - now - spinMargin);
+		while (Clock::now() < deadline)
+			std::this_thread::yield();
+		deadline += framePeriod;
+		return true;
+	}
+
+	unsigned long long GetFrameCount() const {
+		return framesPaced;
+	}
+
+	unsigned long long GetMissedDeadlines() const {
+		return missedDeadlines;
+	}
+};